@@ -9,10 +9,21 @@
 #include <QStack>
 #include <QColor>
 #include <QTimer>
-#include <QPixmap>
+#include <QImage>
+#include <QPolygon>
+#include <QReadWriteLock>
+#include <functional>
 #include <memory>
 #include "Shapes/Shape.h"
+#include "Shapes/ImageShape.h"
 #include "ToolBar.h"
+#include "Viewport.h"
+#include "SpatialIndex.h"
+#include "SnapEngine.h"
+#include "Layer.h"
+#include "Rendering/TileCache.h"
+#include "Rendering/ShapeSprite.h"
+#include "Rendering/PolygonClip.h"
 
 class CanvasWidget : public QWidget
 {
@@ -29,8 +40,12 @@ public:
     bool exportAsImage(const QString& filePath);
     bool loadFromFile(const QString &fileName);
     bool loadBackgroundImage(const QString& filePath);
+    // Places the image at its natural size in the middle of the view.
+    bool insertImage(const QString& filePath);
     
     bool isModified() const { return m_modified; }
+    // SnapEngine::Target flags.
+    int32_t snapTargets() const { return m_snap.targets(); }
 
 public slots:
     void undo();
@@ -41,11 +56,41 @@ public slots:
     void resizePolygonSides(int32_t sides);
     void deleteSelectedShape();
     QList<QString> getShapeList() const;
+    QList<QString> getLayerList() const;
+    int32_t activeLayerIndex() const { return m_activeLayer; }
+    bool isLayerVisible(int32_t index) const;
+    bool isLayerLocked(int32_t index) const;
+    qreal layerOpacity(int32_t index) const;
     void selectShapeFromList(size_t index);
     void stopAllAnimations();
     void moveShapeUp();
     void moveShapeDown();
+    void groupSelection();
+    void ungroupSelection();
+    void convertToSymbol();
+    void cloneSelection();
+    void unionSelection();
+    void intersectSelection();
+    void subtractSelection();
+    void addLayer();
+    void removeLayer();
+    void raiseLayer();
+    void lowerLayer();
+    void setActiveLayer(int32_t index);
+    void setLayerVisible(int32_t index, bool visible);
+    void setLayerLocked(int32_t index, bool locked);
+    void setLayerOpacity(int32_t index, qreal opacity);
     void setFillColor(const QColor& color, bool enabled);
+    // Gradient of the selected shapes' fills, from their fill colour to end.
+    void setFillGradient(ShapeStyle::Gradient kind, const QColor& end, qreal angle);
+    // Effects of the selected shapes; zero radius or a transparent colour
+    // turns them off.
+    void setBlur(qreal radius);
+    void setDropShadow(const QColor& color, const QPointF& offset, qreal radius);
+    void zoomIn();
+    void zoomOut();
+    void zoomToFit();
+    void setSnapTargets(int32_t targets);
 
 signals:
     void modificationChanged(bool modified);
@@ -53,6 +98,7 @@ signals:
     void redoAvailable(bool available);
     void shapeSelected(QString shapeName);
     void shapeListChanged();
+    void layersChanged();
     void updateShapeParameters(const QColor& penColor, int32_t penWidth, const QColor& fillColor, bool isFilled, const QSize& size, double rotation);
 
 protected:
@@ -61,44 +107,158 @@ protected:
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    bool event(QEvent *event) override;
 
 private:
+    // Layers are shared with the live document; each keeps the shape list
+    // it had when the state was taken.
     struct CanvasState {
-        QList<std::shared_ptr<Shape>> shapes;
+        QList<std::shared_ptr<Layer>> layers;
+        QList<QList<std::shared_ptr<Shape>>> shapes;
+        int32_t activeLayer = 0;
     };
 
     ToolBar::Tool m_currentTool = ToolBar::SelectTool;
     QColor m_penColor = Qt::black;
+    // Colour for the fill tool; the pen colour until one is picked.
+    QColor m_fillColor;
     int32_t m_penWidth = 6;
     bool m_modified = false;
 
     QSize m_originalSize = QSize(800, 600);
-    qreal m_scaleFactor = 1.0;
+    Viewport m_viewport;
+    bool m_viewportAdjusted = false;
+    bool m_isPanning = false;
+    QPointF m_panOrigin;
     
-    QList<std::shared_ptr<Shape>> m_shapes;
     QStack<CanvasState> m_undoStack;
     QStack<CanvasState> m_redoStack;
     
     std::shared_ptr<Shape> m_currentShape = nullptr;
+    // m_selection is kept in stacking order; m_selectedShape is its only
+    // member when exactly one shape is selected.
     std::shared_ptr<Shape> m_selectedShape = nullptr;
+    QList<std::shared_ptr<Shape>> m_selection;
+    mutable QRect m_selectionBounds;
+    mutable bool m_selectionBoundsDirty = true;
     QPoint m_lastPoint;
     bool m_isDrawing = false;
     
     void pushUndoState();
+    CanvasState currentState() const;
+    void restoreState(const CanvasState& state);
     void updateModification(bool modified);
     void checkUndoRedo();
     
     std::shared_ptr<Shape> createShape(ToolBar::Tool tool, const QPoint &startPoint);
-    void selectShapeAt(const QPoint &pos);
+    Layer& activeLayer() { return *m_layers[m_activeLayer]; }
+    const Layer& activeLayer() const { return *m_layers[m_activeLayer]; }
+    std::shared_ptr<Layer> createLayer(const QString& name);
+    // Drops cached paths and effects of shapes no longer on any layer.
+    void prunePaths();
+    // Topmost shape at pos among editable layers; reports its layer.
+    std::shared_ptr<Shape> shapeAt(const QPoint &pos, int32_t* layerIndex = nullptr) const;
+    void setSelection(const QList<std::shared_ptr<Shape>>& shapes);
+    void selectInBand(bool extend);
+    QRect selectionBounds() const;
     void moveSelectedShape(const QPoint &delta);
     void scaleShapes();
+    void drawSelection(QPainter& painter) const;
+    void drawGrid(QPainter& painter) const;
+    void drawSnapHit(QPainter& painter) const;
+
+    QPoint toWorld(const QPointF& devicePos) const;
+    void zoomBy(const QPointF& devicePos, qreal factor);
+    void addShape(const std::shared_ptr<Shape>& shape);
+    void modifyShape(const std::shared_ptr<Shape>& shape, const std::function<void(Shape&)>& edit);
+    // Applies the edit to every shape under one lock, index pass and
+    // tile invalidation.
+    void modifyShapes(const QList<std::shared_ptr<Shape>>& shapes, const std::function<void(Shape&)>& edit);
+    void modifyShapes(Layer& layer, const QList<std::shared_ptr<Shape>>& shapes, const std::function<void(Shape&)>& edit);
+    // Swaps the selected shapes on the active layer for edited clones as
+    // one undo step. Shapes are shared with undo states, so every undoable
+    // edit goes through here rather than modifyShapes.
+    void editSelection(const std::function<void(Shape&)>& edit);
+    void documentChanged();
+    void beginSpriteDrag();
+    void updateSpriteDrag(const QPoint& pos);
+    void endSpriteDrag();
+    // Repaints every image shape drawn from a pyramid that just decoded.
+    void imageLoaded(const ImagePyramid* pyramid);
+    void imageRegionLoaded(const ImagePyramid* pyramid, const QRectF& area);
+    // Cuts freehand strokes and curves on the active layer along one
+    // eraser step.
+    void eraseAlong(const QPoint& from, const QPoint& to);
+    // A curve through the stroke points styled like source, or nullptr
+    // when they are too few.
+    std::shared_ptr<Shape> fitCurve(const QVector<QPoint>& points, const Shape& source) const;
+    // Asks for text to place at pos, or to replace a label under it.
+    void editText(const QPoint& pos);
+    // Adds a polygon covering the enclosed area around pos.
+    void bucketFill(const QPoint& pos);
+    // Replaces the selected closed shapes with their combined outline,
+    // taken in stacking order; a difference cuts the rest from the lowest.
+    void combineSelection(PolygonClip::Operation operation);
+    // Visible layers drawn without antialiasing, scale pixels per unit.
+    QImage renderScene(const QRectF& worldRect, qreal scale) const;
 
     QTimer m_animationTimer;
 
-    enum DragMode { NoDrag, MoveDrag, ResizeDrag, RotateDrag };
+    enum DragMode { NoDrag, MoveDrag, ResizeDrag, RotateDrag, MarqueeDrag };
     DragMode m_dragMode = NoDrag;
+    QPoint m_dragOrigin;
+
+    // Rubber band in world coordinates; a lasso keeps every point.
+    QPolygon m_band;
+    bool m_lassoBand = false;
+
+    // Multi-selections and shapes at least this complex are dragged as a
+    // bitmap and transformed once on release.
+    static constexpr int32_t SpriteComplexity = 256;
+    QRect m_dragBounds;
+    std::unique_ptr<ShapeSprite> m_dragSprite;
+    // Set once a live drag has swapped the shape for its edited copy.
+    bool m_dragDetached = false;
+    // Eraser radius in device pixels.
+    static constexpr int32_t EraserRadius = 8;
+    bool m_isErasing = false;
+    // Set once the current eraser drag has pushed its undo state.
+    bool m_eraseChanged = false;
+    // Whether the current tool places points that snap.
+    bool snapsWhileDrawing() const;
+    // Snaps a world point to the nearest target on a visible layer.
+    QPoint snapPoint(const QPoint& pos, const QSet<const Shape*>& exclude = {});
+    // Offset from the drag start that puts a corner or the centre of the
+    // dragged bounds on a target.
+    QPoint snapMove(const QPoint& offset);
+    QList<const SpatialIndex*> snapIndexes() const;
+    SnapEngine m_snap;
+    // Target the last snapped point landed on, shown while dragging.
+    SnapEngine::Hit m_snapHit;
+    bool m_hasSnapHit = false;
+    // Snap reach in device pixels.
+    static constexpr int32_t SnapRadius = 8;
+    // Closest the grid lines are drawn, in device pixels.
+    static constexpr int32_t MinGridSpacing = 8;
+    // Largest distance, in device pixels, between a stroke and its curve.
+    static constexpr qreal CurveTolerance = 1.5;
+    // Distance between a clone and the instance it was cloned from.
+    static constexpr int32_t CloneOffset = 10;
+    // Larger selections only show their combined bounds.
+    static constexpr int32_t MaxOutlinedShapes = 256;
 
-    QPixmap m_backgroundImage;
+    // Guards shape geometry against the tile render workers.
+    QReadWriteLock m_documentLock;
+    // Shared by the background and every layer's tile cache.
+    TileRenderer m_renderer{m_documentLock};
+    // Page colour and the background image, if any.
+    std::shared_ptr<ImageShape> m_background;
+    SpatialIndex m_backgroundIndex;
+    TileCache m_backgroundTiles;
+    // Bottom layer first. There is always at least one.
+    QList<std::shared_ptr<Layer>> m_layers;
+    int32_t m_activeLayer = 0;
 };
 
 #endif // CANVASWIDGET_H
\ No newline at end of file
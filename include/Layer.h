@@ -0,0 +1,37 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <QList>
+#include <QString>
+#include <memory>
+#include "Shapes/Shape.h"
+#include "SpatialIndex.h"
+#include "Rendering/TileCache.h"
+
+// A document layer: its shapes in stacking order, their spatial index and
+// a tile cache of the layer alone on a transparent background. Edits to
+// one layer only ever invalidate that layer's tiles; the renderer behind
+// them belongs to the canvas.
+struct Layer
+{
+    Layer(const QString& name, TileRenderer& renderer);
+
+    // Hidden or locked layers cannot be picked or edited.
+    bool isEditable() const { return visible && !locked; }
+    // Re-indexes the shape list after it was replaced wholesale.
+    void rebuild();
+
+    QJsonObject toJson() const;
+    void fromJson(const QJsonObject& obj);
+
+    QString name;
+    bool visible = true;
+    bool locked = false;
+    qreal opacity = 1.0;
+
+    QList<std::shared_ptr<Shape>> shapes;
+    SpatialIndex index;
+    TileCache tiles;
+};
+
+#endif // LAYER_H
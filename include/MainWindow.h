@@ -4,6 +4,8 @@
 #include <QMainWindow>
 #include <QStatusBar>
 #include <QListWidget>
+#include <QCheckBox>
+#include <QSlider>
 #include "CanvasWidget.h"
 #include "ToolBar.h"
 
@@ -25,8 +27,15 @@ private slots:
     bool saveAs();
     void exportAsImage();
     void importBackground();
+    void insertImage();
     void about();
     void updateShapeList();
+    void updateLayerList();
+    void updateLayerControls();
+    void updateSnapping();
+    void editGradient();
+    void editBlur();
+    void editShadow();
 
 private:
     void createActions();
@@ -45,6 +54,7 @@ private:
 
     QMenu *m_fileMenu;
     QMenu *m_editMenu;
+    QMenu *m_viewMenu;
     QMenu *m_helpMenu;
 
     QAction *m_newAct;
@@ -53,10 +63,26 @@ private:
     QAction *m_saveAsAct;
     QAction *m_exportImageAct;
     QAction *m_importBackgroundAct;
+    QAction *m_insertImageAct;
     QAction *m_exitAct;
     QAction *m_undoAct;
     QAction *m_redoAct;
     QAction *m_clearAct;
+    QAction *m_groupAct;
+    QAction *m_ungroupAct;
+    QAction *m_symbolAct;
+    QAction *m_cloneAct;
+    QAction *m_unionAct;
+    QAction *m_intersectAct;
+    QAction *m_subtractAct;
+    QAction *m_gradientAct;
+    QAction *m_blurAct;
+    QAction *m_shadowAct;
+    QAction *m_zoomInAct;
+    QAction *m_zoomOutAct;
+    QAction *m_zoomFitAct;
+    QAction *m_snapGridAct;
+    QAction *m_snapObjectsAct;
     QAction *m_aboutAct;
 
     QListWidget* m_shapeListWidget;
@@ -65,6 +91,14 @@ private:
     QPushButton* m_moveDownButton;
 
     QPushButton* m_stopAnimationButton;
+
+    QListWidget* m_layerListWidget;
+    QPushButton* m_addLayerButton;
+    QPushButton* m_removeLayerButton;
+    QPushButton* m_raiseLayerButton;
+    QPushButton* m_lowerLayerButton;
+    QCheckBox* m_lockLayerCheck;
+    QSlider* m_layerOpacitySlider;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
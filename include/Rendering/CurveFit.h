@@ -0,0 +1,26 @@
+#ifndef CURVEFIT_H
+#define CURVEFIT_H
+
+#include <QPoint>
+#include <QPointF>
+#include <QVector>
+
+// Fits cubic Bézier segments to sampled strokes (Schneider, Graphics Gems
+// 1990). A curve is stored as its start point followed by two control
+// points and an end point per segment.
+namespace CurveFit {
+    // Newton-Raphson passes tried before a segment is split.
+    constexpr int32_t MaxIterations = 4;
+
+    // Segments that stay within error of every sample. Consecutive
+    // segments join with a continuous tangent. Empty for fewer than two
+    // distinct points.
+    QVector<QPointF> fit(const QVector<QPoint>& points, qreal error);
+
+    // Point at t on the segment whose four points start at segment.
+    QPointF pointAt(const QPointF* segment, qreal t);
+    // Straight pieces needed to stay within tolerance of the segment.
+    int32_t flattenSteps(const QPointF* segment, qreal tolerance);
+}
+
+#endif // CURVEFIT_H
@@ -0,0 +1,79 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QPainter>
+#include <QRectF>
+#include <list>
+#include "../Shapes/Shape.h"
+
+// Blur and drop shadow for shapes whose style asks for them. The shape is
+// drawn into an offscreen buffer, filtered there and drawn back as an
+// image covering its bounds grown by the style's effect margin.
+namespace Effects {
+    // Longest side of an effect buffer; larger ones render coarser.
+    constexpr int32_t MaxSize = 4096;
+
+    struct Result {
+        QImage image;
+        // Where the image goes, in world coordinates.
+        QRectF rect;
+    };
+
+    // Blurs an ARGB32 premultiplied image in place with three box passes
+    // per axis, approximating a Gaussian with this standard deviation in
+    // pixels. Pixels beyond the edges count as transparent.
+    void blur(QImage& image, qreal sigma);
+
+    // The shape with its effects applied, rendered at the given scale.
+    Result render(const Shape& shape, qreal scale);
+    // Draws the shape with its effects, or plainly when it has none.
+    void draw(QPainter& painter, const Shape& shape, qreal scale);
+}
+
+// Filtered images per shape and resolution level, shared by all render
+// workers. Like PathCache, entries are keyed on the shape's version, so a
+// static blurred shape costs one blit per tile.
+class EffectCache
+{
+public:
+    // Least recently used entries are dropped beyond this many pixels.
+    static constexpr qint64 MaxPixels = 16 * 1024 * 1024;
+
+    Effects::Result result(const Shape& shape, qreal scale);
+
+    template <typename Predicate>
+    void prune(Predicate isLive) {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (isLive(it.key().first)) {
+                ++it;
+            } else {
+                m_pixels -= pixelCount(it->result.image);
+                m_order.erase(it->position);
+                it = m_entries.erase(it);
+            }
+        }
+    }
+
+private:
+    using Key = QPair<const Shape*, int32_t>;
+    struct Entry {
+        quint64 version = 0;
+        std::list<Key>::iterator position;
+        Effects::Result result;
+    };
+
+    static qint64 pixelCount(const QImage& image) { return qint64(image.width()) * image.height(); }
+    void evict();
+
+    QMutex m_mutex;
+    QHash<Key, Entry> m_entries;
+    // Keys from most to least recently used.
+    std::list<Key> m_order;
+    qint64 m_pixels = 0;
+};
+
+#endif // EFFECTS_H
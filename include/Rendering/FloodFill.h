@@ -0,0 +1,39 @@
+#ifndef FLOODFILL_H
+#define FLOODFILL_H
+
+#include <QImage>
+#include <QList>
+#include <QPoint>
+#include <QPolygon>
+#include <QVector>
+
+// Bucket fill over a rendered scene. The region of the seed colour is
+// filled span by span and its outline traced back into polygon rings.
+namespace FloodFill {
+    // Longest side of the scene raster; larger areas are sampled coarser.
+    constexpr int32_t MaxRasterSize = 2048;
+
+    struct Mask {
+        int32_t width = 0;
+        int32_t height = 0;
+        // One byte per pixel, non-zero inside the region.
+        QVector<uchar> bits;
+
+        bool at(int32_t x, int32_t y) const {
+            return x >= 0 && y >= 0 && x < width && y < height && bits[y * width + x];
+        }
+    };
+
+    // The 4-connected region of pixels sharing the seed's colour in a
+    // 32-bit image. Reports whether it reached the image border.
+    Mask fill(const QImage& image, const QPoint& seed, bool* reachedBorder = nullptr);
+
+    // Closed outlines along pixel edges: the outer boundary first, then
+    // the holes.
+    QList<QPolygon> trace(const Mask& mask);
+    // Simplifies the outer ring and its holes, dropping holes that
+    // collapse under the tolerance. Empty when the outer ring collapses.
+    QList<QPolygon> simplify(const QList<QPolygon>& rings, qreal tolerance);
+}
+
+#endif // FLOODFILL_H
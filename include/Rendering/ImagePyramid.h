@@ -0,0 +1,119 @@
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+class ImagePyramid;
+
+// Announces finished pyramids on the GUI thread.
+class ImagePyramidNotifier : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void loaded(const ImagePyramid* pyramid);
+    // A detail tile of a tiled image arrived; area is in image pixels.
+    void regionLoaded(const ImagePyramid* pyramid, const QRectF& area);
+};
+
+// An image file decoded on a worker thread, together with successively
+// halved copies. Drawing picks the level closest to the size on screen,
+// so no frame ever rescales the full image.
+//
+// Images above MaxDecodedPixels are never held whole. Only a downscaled
+// overview is kept in the pyramid; sharper pixels come from detail tiles
+// read on demand with QImageReader clip/scaled reads and kept in a small
+// least-recently-used set.
+class ImagePyramid : public std::enable_shared_from_this<ImagePyramid>
+{
+public:
+    // Levels stop halving once the longer side is this small.
+    static constexpr int32_t MinLevelSize = 32;
+    static constexpr qint64 MaxDecodedPixels = qint64(4096) * 4096;
+    // Longer side of the overview of a tiled image.
+    static constexpr int32_t OverviewSize = 2048;
+    static constexpr int32_t DetailTileSize = 512;
+    // Working set per image, about 1 MiB per tile.
+    static constexpr int32_t MaxDetailTiles = 128;
+
+    // Files are decoded once and shared by everything showing them.
+    // Returns nullptr for files that are not readable images.
+    static std::shared_ptr<ImagePyramid> load(const QString& path);
+    // Must first be called on the GUI thread; load() does so.
+    static ImagePyramidNotifier* notifier();
+
+    explicit ImagePyramid(const QString& path, const QSize& size);
+
+    QString path() const { return m_path; }
+    // Full size, read from the file header before decoding.
+    QSize size() const { return m_size; }
+    bool isReady() const { return m_ready.load(std::memory_order_acquire); }
+
+    // The smallest level covering size pixels, or the full image when
+    // none does. Null until decoded. Safe to call from any thread.
+    QImage level(const QSizeF& size) const;
+
+    bool isTiled() const { return m_tiled; }
+    // Detail level 0 is full resolution; each next level halves it.
+    // Returns the coarsest level at least as sharp as size pixels.
+    int32_t detailLevel(const QSizeF& size) const;
+    QSize levelSize(int32_t level) const;
+    // Detail tiles of a level overlapping rect, given in that level's pixels.
+    QRect tileRange(int32_t level, const QRectF& rect) const;
+    QRect tileRect(int32_t level, const QPoint& tile) const;
+
+    // The decoded tile, or null while it is read in the background and
+    // regionLoaded() announces it. With wait set it is read right away.
+    QImage detailTile(int32_t level, const QPoint& tile, bool wait = false);
+    // Queues reads for the tiles in range that are not cached yet.
+    void prefetch(int32_t level, const QRect& range);
+
+private:
+    struct DetailKey {
+        int32_t level = 0;
+        int32_t x = 0;
+        int32_t y = 0;
+
+        bool operator==(const DetailKey& other) const {
+            return level == other.level && x == other.x && y == other.y;
+        }
+        friend size_t qHash(const DetailKey& key, size_t seed = 0) {
+            return qHashMulti(seed, key.level, key.x, key.y);
+        }
+    };
+
+    struct Detail {
+        QImage image;
+        quint64 lastUsed = 0;
+        bool pending = false;
+    };
+
+    void build();
+    QImage readDetail(const DetailKey& key) const;
+    void requestDetail(const DetailKey& key);
+    void decodeDetail(const DetailKey& key);
+    void evictDetails();
+
+    const QString m_path;
+    const QSize m_size;
+    const bool m_tiled;
+
+    mutable std::mutex m_mutex;
+    QVector<QImage> m_levels;
+    std::atomic<bool> m_ready{false};
+
+    // Guarded by m_mutex.
+    QHash<DetailKey, Detail> m_details;
+    quint64 m_clock = 0;
+};
+
+#endif // IMAGEPYRAMID_H
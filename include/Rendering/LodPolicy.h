@@ -0,0 +1,32 @@
+#ifndef LODPOLICY_H
+#define LODPOLICY_H
+
+#include <QPainter>
+#include <QVector>
+#include <QPoint>
+#include <QRect>
+#include "../Shapes/Shape.h"
+
+// Level-of-detail rules for the tile render path. Every simplification
+// keeps the rendered result within one device pixel of the full draw.
+namespace Lod {
+    // Shapes whose bounds fit in this many device pixels draw as a box.
+    constexpr qreal MinFeatureSize = 2.0;
+    // Polylines are only simplified when the tolerance is worth it.
+    constexpr qreal MinTolerance = 0.5;
+    constexpr int32_t MinLevel = -8;
+
+    // Resolution level for a device scale: 2^level >= scale.
+    int32_t levelForScale(qreal scale);
+    // World-space tolerance giving at most half a device pixel of error.
+    qreal toleranceForLevel(int32_t level);
+
+    // Ramer-Douglas-Peucker simplification of an open polyline.
+    QVector<QPoint> simplify(const QVector<QPoint>& points, qreal tolerance);
+
+    // Whether a shape with these world bounds is drawn as a plain box.
+    bool isTiny(const QRect& bounds, qreal scale);
+    QColor boxColor(const Shape& shape);
+}
+
+#endif // LODPOLICY_H
@@ -0,0 +1,36 @@
+#ifndef POLYGONCLIP_H
+#define POLYGONCLIP_H
+
+#include <QList>
+#include <QPainterPath>
+#include <QPolygon>
+#include <QPolygonF>
+
+// Boolean operations on closed outlines under the odd-even rule. Edges are
+// snapped to a fixed-point grid and snap rounded: every vertex and every
+// crossing (found with a sweep over x) marks a hot pixel, and each edge
+// is re-split through the centre of every hot pixel it passes, so the
+// fragments never cross. Fragments are classified against the other
+// operand's fragments and linked back into rings. All predicates on the
+// grid are exact integer arithmetic.
+namespace PolygonClip {
+    enum Operation { Union, Intersection, Difference };
+
+    // Coordinates are held in 1/FixedScale world units while clipping.
+    constexpr int32_t FixedScale = 16;
+    // Largest distance between a curve and its flattened outline.
+    constexpr qreal DefaultTolerance = 0.25;
+
+    // The subpaths of path as rings, with curves flattened adaptively.
+    QList<QPolygonF> flatten(const QPainterPath& path, qreal tolerance = DefaultTolerance);
+
+    // Outline of a combined with b; Difference keeps a minus b. Rings are
+    // open, and together they describe the result under the odd-even rule.
+    QList<QPolygonF> apply(const QList<QPolygonF>& a, const QList<QPolygonF>& b, Operation operation);
+
+    // Splits rings into separate pieces, each an outer ring followed by
+    // the holes directly inside it, rounded to whole units and closed.
+    QList<QList<QPolygon>> pieces(const QList<QPolygonF>& rings);
+}
+
+#endif // POLYGONCLIP_H
@@ -0,0 +1,93 @@
+#ifndef RENDERLIST_H
+#define RENDERLIST_H
+
+#include <QBrush>
+#include <QHash>
+#include <QMutex>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPen>
+#include <QVector>
+#include <list>
+#include <memory>
+#include "Effects.h"
+#include "../Shapes/Shape.h"
+
+// World-space render paths per shape and resolution level, shared by all
+// render workers. Entries are keyed on the shape's version, so an edited
+// shape simply misses and is rebuilt.
+class PathCache
+{
+public:
+    // Least recently used entries are dropped beyond this many bytes of
+    // path elements.
+    static constexpr qint64 MaxBytes = 32 * 1024 * 1024;
+
+    QPainterPath path(const Shape& shape, qreal scale);
+    // Drops entries for shapes that are no longer alive in the document.
+    template <typename Predicate>
+    void prune(Predicate isLive) {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (isLive(it.key().first)) {
+                ++it;
+            } else {
+                m_bytes -= byteCount(it->path);
+                m_order.erase(it->position);
+                it = m_entries.erase(it);
+            }
+        }
+    }
+
+private:
+    using Key = QPair<const Shape*, int32_t>;
+    struct Entry {
+        quint64 version = 0;
+        std::list<Key>::iterator position;
+        QPainterPath path;
+    };
+
+    static qint64 byteCount(const QPainterPath& path) {
+        return qint64(path.elementCount()) * qint64(sizeof(QPainterPath::Element));
+    }
+    void evict();
+
+    QMutex m_mutex;
+    QHash<Key, Entry> m_entries;
+    // Keys from most to least recently used.
+    std::list<Key> m_order;
+    qint64 m_bytes = 0;
+};
+
+// Compiles a z-ordered list of shapes into batches that share pen and
+// brush, so a tile issues one state change and one drawPath per run
+// instead of a save/restore per shape. Shapes with effects are drawn as
+// cached images between the batches.
+class RenderList
+{
+public:
+    void compile(const QList<std::shared_ptr<Shape>>& shapes, const QVector<QRect>& bounds,
+                 qreal scale, PathCache& cache, EffectCache& effects);
+    void draw(QPainter& painter) const;
+
+    qsizetype batchCount() const { return m_batches.size(); }
+
+private:
+    struct Batch {
+        QPen pen;
+        QBrush brush;
+        QPainterPath path;
+        QRect bounds;
+        // Merging is only exact when no member can show through another.
+        bool overlapSensitive = false;
+        const Shape* fallback = nullptr;
+        Effects::Result effect;
+    };
+
+    void append(const QPen& pen, const QBrush& brush, const QPainterPath& path, const QRect& bounds);
+
+    QVector<Batch> m_batches;
+    qreal m_scale = 1.0;
+};
+
+#endif // RENDERLIST_H
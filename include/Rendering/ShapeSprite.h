@@ -0,0 +1,39 @@
+#ifndef SHAPESPRITE_H
+#define SHAPESPRITE_H
+
+#include <QImage>
+#include <QList>
+#include <QPainter>
+#include <QRect>
+#include <QTransform>
+#include <memory>
+#include "../Shapes/Shape.h"
+
+// Shapes rasterized once and then drawn as a transformed bitmap, so a
+// complex shape or a large selection can be dragged without touching
+// any geometry per frame.
+class ShapeSprite
+{
+public:
+    // Longest side of the offscreen image; larger sprites are downscaled.
+    static constexpr int32_t MaxSize = 4096;
+
+    // shapes are drawn in list order. bounds are their world bounds
+    // including anything drawn past boundingRect(); scale is the device
+    // scale the sprite is shown at.
+    ShapeSprite(const QList<std::shared_ptr<Shape>>& shapes, const QRect& bounds, qreal scale);
+
+    // World-space transform applied on top of the captured position.
+    void setTransform(const QTransform& transform) { m_transform = transform; }
+    QTransform transform() const { return m_transform; }
+
+    // Expects a painter in world coordinates.
+    void draw(QPainter& painter) const;
+
+private:
+    QImage m_image;
+    QRect m_bounds;
+    QTransform m_transform;
+};
+
+#endif // SHAPESPRITE_H
@@ -0,0 +1,81 @@
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include "TileRenderer.h"
+#include "../SpatialIndex.h"
+#include "../Viewport.h"
+
+struct TileKey {
+    int32_t level = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+
+    bool operator==(const TileKey& other) const {
+        return level == other.level && x == other.x && y == other.y;
+    }
+};
+
+inline size_t qHash(const TileKey& key, size_t seed = 0) {
+    return qHashMulti(seed, key.level, key.x, key.y);
+}
+
+// Cache of rendered document tiles at power-of-two zoom levels. Tiles at
+// level L cover TileSize / 2^L world units and are drawn at scale 2^L.
+// Visible tiles that are missing are rendered in the background while the
+// nearest coarser level stands in for them.
+class TileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int32_t TileSize = TileRenderer::TileSize;
+    static constexpr int32_t MaxTiles = 1024;
+    static constexpr int32_t MaxFallbackLevels = 4;
+    // Coarse tiles prefetched around the viewport for fast pan and zoom out.
+    static constexpr int32_t PrefetchLevelOffset = 2;
+
+    TileCache(const SpatialIndex& index, TileRenderer& renderer, QObject* parent = nullptr);
+
+    void setClearColor(const QColor& color);
+
+    void invalidate(const QRect& worldRect);
+    void invalidateAll();
+
+    void paint(QPainter& painter, const Viewport& viewport, const QSize& viewportSize);
+
+signals:
+    void tilesReady();
+
+private:
+    struct Tile {
+        QImage image;
+        quint64 generation = 0;
+        quint64 lastUsed = 0;
+        bool dirty = true;
+        bool pending = false;
+    };
+
+    static qreal tileWorldSize(int32_t level);
+    static QRectF tileWorldRect(const TileKey& key);
+    static QRect tileRange(const QRectF& worldRect, int32_t level);
+
+    bool isReady(const TileKey& key) const;
+    bool findFallback(const TileKey& key, TileKey& fallback) const;
+    TileRenderer::Job makeJob(const TileKey& key) const;
+    void requestAsync(const TileKey& key);
+    void finishAsync(const TileKey& key, quint64 generation, const QImage& image);
+    void evict();
+
+    const SpatialIndex& m_index;
+    TileRenderer& m_renderer;
+
+    QHash<TileKey, Tile> m_tiles;
+    quint64 m_frame = 0;
+    QColor m_clearColor = Qt::white;
+};
+
+#endif // TILECACHE_H
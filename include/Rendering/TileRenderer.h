@@ -0,0 +1,58 @@
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+
+#include <QColor>
+#include <QImage>
+#include <QList>
+#include <QReadWriteLock>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include "RenderList.h"
+#include "../Shapes/Shape.h"
+
+// Rasterizes square world-space tiles on a thread pool. Workers only read
+// shapes under the document read lock; the canvas takes the write lock
+// before it mutates a shape. One renderer serves every layer's tile cache,
+// so the pool and the path and effect caches are shared between them.
+class TileRenderer
+{
+public:
+    static constexpr int32_t TileSize = 256;
+
+    struct Job {
+        QRectF worldRect;
+        qreal scale = 1.0;
+        // Tiles start out filled with this; transparent for overlay layers.
+        QColor clearColor = Qt::white;
+        QList<std::shared_ptr<Shape>> shapes;
+        // Indexed bounds of each shape, used for level-of-detail decisions.
+        QVector<QRect> bounds;
+    };
+
+    explicit TileRenderer(QReadWriteLock& documentLock);
+    ~TileRenderer();
+
+    // Renders all jobs in parallel and blocks until they are done.
+    QVector<QImage> renderBatch(const QVector<Job>& jobs);
+    // Renders in the background; done() is called on a worker thread.
+    void renderAsync(const Job& job, std::function<void(QImage)> done);
+
+    // Drops cached paths and effect images of shapes that are gone.
+    template <typename Predicate>
+    void prunePaths(Predicate isLive) {
+        m_pathCache.prune(isLive);
+        m_effectCache.prune(isLive);
+    }
+
+private:
+    QImage renderTile(const Job& job);
+
+    QReadWriteLock& m_documentLock;
+    QThreadPool m_pool;
+    PathCache m_pathCache;
+    EffectCache m_effectCache;
+};
+
+#endif // TILERENDERER_H
@@ -3,12 +3,13 @@
 
 #include "Shape.h"
 
-class CircleShape : public Shape {
+class CircleShape final : public Shape {
 public:
     CircleShape() = default;
     CircleShape(const QPoint& topLeft, const QPoint& bottomRight);
     
     void draw(QPainter& painter) const override;
+    QPainterPath renderPath(qreal scale) const override;
     bool contains(const QPoint& pos) const override;
     void moveBy(int32_t dx, int32_t dy) override;
     void resize(const QSize& size) override;
@@ -16,10 +17,10 @@ public:
     void update(const QPoint& toPoint) override;
     QString name() const override;
 
-    void setFillColor(const QColor& color) override { fillColor = color; }
-    void setFilled(bool filled) override { isFilled = filled; }
-    QColor getFillColor() const override { return fillColor; }
-    bool isShapeFilled() const override { return isFilled; }
+    void setFillColor(const QColor& color) override { setStyle(style().withFill(color)); }
+    void setFilled(bool filled) override { setStyle(style().withFilled(filled)); }
+    QColor getFillColor() const override { return style().fill; }
+    bool isShapeFilled() const override { return style().filled; }
     
     QRect boundingRect() const override;
 
@@ -30,8 +31,6 @@ public:
 
 private:
     QRect m_rect;
-    QColor fillColor;
-    bool isFilled;
 
     QPoint m_velocity = {3, 3};
 };
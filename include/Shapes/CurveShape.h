@@ -0,0 +1,56 @@
+#ifndef CURVESHAPE_H
+#define CURVESHAPE_H
+
+#include "Shape.h"
+#include <QPointF>
+#include <QTransform>
+#include <QVector>
+
+// A smooth stroke made of cubic Bézier segments, stored as the start point
+// followed by two control points and an end point per segment. Finished
+// freehand strokes are fitted into these.
+class CurveShape final : public Shape
+{
+public:
+    CurveShape() = default;
+    explicit CurveShape(const QVector<QPointF>& points);
+
+    void draw(QPainter& painter) const override;
+    QPainterPath renderPath(qreal scale) const override;
+    QPen renderPen() const override { return style().roundPen(); }
+    bool contains(const QPoint& pos) const override;
+    void moveBy(int32_t dx, int32_t dy) override;
+    void resize(const QSize& size) override;
+    void rotate(double angle) override;
+    // Extends the curve by a straight segment.
+    void update(const QPoint& toPoint) override;
+    QString name() const override { return "Curve"; }
+
+    QRect boundingRect() const override;
+
+    QJsonObject toJson() const override;
+    void fromJson(const QJsonObject& obj) override;
+
+    void animateStep() override;
+    int32_t complexity() const override { return m_points.size(); }
+
+    qsizetype segmentCount() const { return m_points.size() / 3; }
+    // Polyline within tolerance of the curve, in world coordinates with the
+    // rotation baked in.
+    QVector<QPoint> flatten(qreal tolerance) const;
+
+private:
+    // Unrotated geometry.
+    QPainterPath path() const;
+    QTransform rotationTransform() const;
+    void setPoints(const QVector<QPointF>& points);
+
+    QVector<QPointF> m_points;
+    // Exact bounds of the unrotated curve; rotation turns about its centre.
+    QRectF m_extent;
+
+    double m_angle = 0.0;
+    int32_t m_hue = 0;
+};
+
+#endif // CURVESHAPE_H
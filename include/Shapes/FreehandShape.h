@@ -2,14 +2,22 @@
 #define FREEHANDSHAPE_H
 
 #include "Shape.h"
+#include "PointStream.h"
+#include <QLineF>
+#include <QList>
+#include <QTransform>
 #include <QVector>
 
-class FreehandShape : public Shape
+class FreehandShape final : public Shape
 {
 public:
     FreehandShape() = default;
+    explicit FreehandShape(const QVector<QPoint>& points) { setPoints(points); }
     
     void draw(QPainter& painter) const override;
+    void drawLod(QPainter& painter, qreal scale) const override;
+    QPainterPath renderPath(qreal scale) const override;
+    QPen renderPen() const override;
     bool contains(const QPoint& pos) const override;
     void moveBy(int32_t dx, int32_t dy) override;
     void resize(const QSize& size) override;
@@ -23,9 +31,29 @@ public:
     void fromJson(const QJsonObject& obj) override;
 
     void animateStep() override;
+    int32_t complexity() const override { return m_points.size(); }
+    // Unrotated sample points.
+    QVector<QPoint> points() const { return m_points.decode(); }
+
+    // Whether a disc of the given radius swept along the line reaches the
+    // ink. Only the point chunks whose bounds come near it are decoded.
+    bool touches(const QLineF& sweep, qreal radius) const;
+    // Cuts away what the sweep reaches. The rest comes back as one point
+    // run per piece, in world coordinates with the rotation baked in.
+    // Returns false, leaving pieces alone, when nothing was cut.
+    bool erase(const QLineF& sweep, qreal radius, QList<QVector<QPoint>>& pieces) const;
 
 private:
-    QVector<QPoint> m_points;
+    void drawPoints(QPainter& painter, const QVector<QPoint>& points) const;
+    // The stroke simplified for the scale. Not cached here: PathCache
+    // already keeps the tile paths built from it.
+    QVector<QPoint> simplifiedPoints(qreal scale) const;
+    // Rotation about the centre of the unrotated points.
+    QTransform rotationTransform() const;
+    // Replaces the whole stroke and recomputes its extent.
+    void setPoints(const QVector<QPoint>& points);
+
+    PointStream m_points;
     QRect m_boundingRect;
 
     double m_angle = 0.0;
@@ -0,0 +1,87 @@
+#ifndef GROUPSHAPE_H
+#define GROUPSHAPE_H
+
+#include "Shape.h"
+#include "LocalTransform.h"
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QTransform>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// A node holding child shapes in its own local coordinates. Moving,
+// scaling or rotating the group only changes the group transform; the
+// children keep their geometry.
+class GroupShape : public Shape
+{
+public:
+    // Children drawn past their boundingRect() (caps, markers) still fit.
+    static constexpr int32_t LayerMargin = 4;
+    // Longest side of a cached sub-layer; bigger views draw the children.
+    static constexpr int32_t MaxLayerSize = 1024;
+
+    GroupShape() = default;
+    explicit GroupShape(const QList<std::shared_ptr<Shape>>& children);
+
+    void draw(QPainter& painter) const override;
+    void drawLod(QPainter& painter, qreal scale) const override;
+    bool contains(const QPoint& pos) const override;
+    void moveBy(int32_t dx, int32_t dy) override;
+    void resize(const QSize& size) override;
+    void rotate(double angle) override;
+    void update(const QPoint& toPoint) override;
+    QString name() const override { return "Group"; }
+
+    void setColor(const QColor& color) override;
+    void setPenWidth(int32_t width) override;
+    void setFillColor(const QColor& color) override;
+    void setFilled(bool filled) override;
+    QColor getColor() const override;
+    int32_t getPenWidth() const override;
+    QColor getFillColor() const override;
+    bool isShapeFilled() const override;
+
+    QRect boundingRect() const override { return m_bounds; }
+    int32_t complexity() const override;
+
+    QJsonObject toJson() const override;
+    void fromJson(const QJsonObject& obj) override;
+
+    const QList<std::shared_ptr<Shape>>& children() const { return m_children; }
+    QTransform transform() const { return m_transform; }
+    // Copies of the children with the group transform baked into their
+    // own geometry, for ungrouping. The group itself is left untouched.
+    QList<std::shared_ptr<Shape>> bakedChildren() const;
+
+private:
+    // Children rasterized in local coordinates, one image per resolution
+    // level. Only the children's content invalidates it.
+    struct LayerCache {
+        LayerCache() = default;
+        LayerCache(const LayerCache&) {}
+        LayerCache& operator=(const LayerCache&) { levels.clear(); return *this; }
+
+        std::mutex mutex;
+        QHash<int32_t, QImage> levels;
+    };
+    static constexpr int32_t MaxCachedLevels = 3;
+
+    void restyleChildren(const std::function<void(Shape&)>& edit);
+    void childrenChanged();
+    void updateTransform();
+    QImage layerImage(qreal scale) const;
+    QRect layerRect() const { return m_localBounds.adjusted(-LayerMargin, -LayerMargin, LayerMargin, LayerMargin); }
+
+    QList<std::shared_ptr<Shape>> m_children;
+    QRect m_localBounds;
+
+    LocalTransform m_placement;
+    QTransform m_transform;
+    QRect m_bounds;
+
+    mutable LayerCache m_layerCache;
+};
+
+#endif // GROUPSHAPE_H
@@ -0,0 +1,50 @@
+#ifndef IMAGESHAPE_H
+#define IMAGESHAPE_H
+
+#include "Shape.h"
+#include "../Rendering/ImagePyramid.h"
+#include <memory>
+
+// A raster image placed in a rectangle. Pixels come from a shared
+// ImagePyramid; until it has decoded, a placeholder box is drawn.
+class ImageShape final : public Shape
+{
+public:
+    ImageShape() = default;
+    ImageShape(const std::shared_ptr<ImagePyramid>& image, const QRect& rect);
+
+    void draw(QPainter& painter) const override;
+    void drawLod(QPainter& painter, qreal scale) const override;
+    bool contains(const QPoint& pos) const override;
+    void moveBy(int32_t dx, int32_t dy) override;
+    void resize(const QSize& size) override;
+    void rotate(double angle) override;
+    void update(const QPoint& toPoint) override;
+    QString name() const override { return "Image"; }
+
+    QRect boundingRect() const override;
+
+    QJsonObject toJson() const override;
+    void fromJson(const QJsonObject& obj) override;
+
+    const ImagePyramid* image() const { return m_image.get(); }
+    // World bounds of area, given in full-resolution image pixels.
+    QRect mapFromImage(const QRectF& area) const;
+    // Starts reading the detail tiles of a tiled image that cover
+    // worldRect when drawn at scale.
+    void prefetch(const QRectF& worldRect, qreal scale) const;
+
+private:
+    QTransform rotationTransform() const;
+    void drawPixels(QPainter& painter, qreal scale, bool wait) const;
+    void drawDetail(QPainter& painter, const QSizeF& size, bool wait) const;
+    // Detail tiles of level that lie under local, an unrotated world rect.
+    QRect detailRange(int32_t level, const QRectF& local) const;
+
+    // Kept apart from the pyramid so a missing file is still saved back.
+    QString m_path;
+    std::shared_ptr<ImagePyramid> m_image;
+    QRect m_rect;
+};
+
+#endif // IMAGESHAPE_H
@@ -0,0 +1,59 @@
+#ifndef INSTANCESHAPE_H
+#define INSTANCESHAPE_H
+
+#include "Shape.h"
+#include "LocalTransform.h"
+#include "SymbolDefinition.h"
+#include <QTransform>
+#include <memory>
+
+// A placed copy of a SymbolDefinition. It owns only its transform and an
+// optional style override; geometry and render caches are shared.
+class InstanceShape : public Shape
+{
+public:
+    InstanceShape() = default;
+    explicit InstanceShape(std::shared_ptr<SymbolDefinition> symbol);
+
+    void draw(QPainter& painter) const override;
+    void drawLod(QPainter& painter, qreal scale) const override;
+    bool contains(const QPoint& pos) const override;
+    void moveBy(int32_t dx, int32_t dy) override;
+    void resize(const QSize& size) override;
+    void rotate(double angle) override;
+    void update(const QPoint& toPoint) override;
+    QString name() const override { return "Instance"; }
+
+    // Style edits switch the instance from the symbol's own style to an
+    // override; this only applies to single-style symbols.
+    void setColor(const QColor& color) override;
+    void setPenWidth(int32_t width) override;
+    void setFillColor(const QColor& color) override;
+    void setFilled(bool filled) override;
+    QColor getColor() const override;
+    int32_t getPenWidth() const override;
+    QColor getFillColor() const override;
+    bool isShapeFilled() const override;
+
+    QRect boundingRect() const override { return m_bounds; }
+
+    QJsonObject toJson() const override;
+    void fromJson(const QJsonObject& obj) override;
+
+    const std::shared_ptr<SymbolDefinition>& symbol() const { return m_symbol; }
+
+private:
+    void beginOverride();
+    void drawSymbol(QPainter& painter, qreal scale) const;
+    void updateTransform();
+
+    std::shared_ptr<SymbolDefinition> m_symbol;
+    LocalTransform m_placement;
+    QTransform m_transform;
+    QRect m_bounds;
+
+    // Whether the base style overrides the symbol's own.
+    bool m_styled = false;
+};
+
+#endif // INSTANCESHAPE_H
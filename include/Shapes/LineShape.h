@@ -3,12 +3,14 @@
 
 #include "Shape.h"
 
-class LineShape : public Shape {
+class LineShape final : public Shape {
 public:
     LineShape() = default;
     LineShape(QPoint from, QPoint to);
 
     void draw(QPainter& painter) const override;
+    QPainterPath renderPath(qreal scale) const override;
+    QPen renderPen() const override;
     bool contains(const QPoint& pos) const override;
     void moveBy(int dx, int dy) override;
     void resize(const QSize& size) override;
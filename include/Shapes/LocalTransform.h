@@ -0,0 +1,26 @@
+#ifndef LOCALTRANSFORM_H
+#define LOCALTRANSFORM_H
+
+#include <QJsonObject>
+#include <QPointF>
+#include <QRect>
+#include <QTransform>
+
+// Placement of content authored in its own local coordinates: scaled
+// about the local top-left, rotated about the scaled centre, then offset.
+struct LocalTransform
+{
+    QPointF offset;
+    qreal scaleX = 1.0;
+    qreal scaleY = 1.0;
+
+    QTransform matrix(const QRect& localBounds, qreal rotation) const;
+    bool isScaled() const { return scaleX != 1.0 || scaleY != 1.0; }
+    // Largest linear scale factor, for picking a resolution level.
+    qreal maxScale() const;
+
+    void write(QJsonObject& obj) const;
+    void read(const QJsonObject& obj);
+};
+
+#endif // LOCALTRANSFORM_H
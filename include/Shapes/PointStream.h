@@ -0,0 +1,78 @@
+#ifndef POINTSTREAM_H
+#define POINTSTREAM_H
+
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+#include "ShapeFactory.h"
+
+// Compact storage for long point runs such as pen strokes. Each chunk
+// keeps one absolute keyframe followed by deltas: one byte per coordinate
+// while samples stay close, two once any step in the chunk is larger.
+// Measured on synthetic strokes, that is about 2.5 bytes a point while
+// steps stay under 128 pixels and 4.5 once they do not, against 8 for a
+// QPoint: a third to a half of the memory, not counting decoded copies.
+class PointStream
+{
+public:
+    static constexpr int32_t ChunkSize = 64;
+
+    PointStream() = default;
+    // A copy belongs to the document being edited, so it allocates from
+    // the current pool rather than the source's.
+    PointStream(const PointStream& other);
+    PointStream& operator=(const PointStream& other);
+
+    void clear();
+    void append(const QPoint& point);
+    // Drops spare capacity after a bulk append.
+    void squeeze();
+
+    qsizetype size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    QPoint first() const { return m_chunks.empty() ? QPoint() : m_chunks.front().origin; }
+    QPoint last() const { return m_last; }
+
+    // Only the keyframes move; the deltas are unchanged.
+    void translate(int32_t dx, int32_t dy);
+
+    QVector<QPoint> decode() const;
+    void decode(QVector<QPoint>& points) const;
+
+    // Chunks double as a segment index: their bounds cover every segment
+    // of the chunk, the one leading into it included, so hit tests only
+    // decode the chunks near the query.
+    qsizetype chunkCount() const { return qsizetype(m_chunks.size()); }
+    QRect chunkBounds(qsizetype chunk) const { return m_chunks[chunk].bounds; }
+    // The chunk's points, led by the point before it when there is one.
+    QVector<QPoint> decodeChunk(qsizetype chunk) const;
+
+private:
+    // 32 bytes, half a byte per point of a full chunk.
+    struct Chunk {
+        QPoint origin;
+        QRect bounds;
+        // First delta byte of the chunk in m_deltas.
+        int32_t offset = 0;
+        // Points in the chunk, the keyframe included.
+        quint8 count = 1;
+        bool wide = false;
+    };
+
+    void widenLastChunk();
+    // Writes the chunk's count points to out.
+    void decodeChunk(const Chunk& chunk, QPoint* out) const;
+
+    // Storage comes from the document's shape pool, held here so it
+    // outlives both buffers.
+    std::shared_ptr<std::pmr::memory_resource> m_pool = ShapeFactory::shapeResource();
+    std::pmr::vector<Chunk> m_chunks{m_pool.get()};
+    std::pmr::vector<char> m_deltas{m_pool.get()};
+    QPoint m_last;
+    qsizetype m_size = 0;
+};
+
+#endif // POINTSTREAM_H
@@ -2,14 +2,20 @@
 #define POLYGONSHAPE_H
 
 #include "../Shapes/Shape.h"
+#include <QList>
 #include <QPolygon>
 
-class PolygonShape : public Shape {
+class PolygonShape final : public Shape {
 public:
     PolygonShape() = default;
     explicit PolygonShape(const QVector<QPoint>& points);
+    // A closed outline with holes cut out of it under the odd-even rule.
+    PolygonShape(const QVector<QPoint>& outline, const QList<QPolygon>& holes);
 
     void draw(QPainter& painter) const override;
+    // Empty while the polygon is still open, so its vertex markers are
+    // drawn by draw().
+    QPainterPath renderPath(qreal scale) const override;
     bool contains(const QPoint& pos) const override;
     void moveBy(int32_t dx, int32_t dy) override;
     void resize(const QSize& size) override;
@@ -17,12 +23,14 @@ public:
     void update(const QPoint& toPoint) override;
     QString name() const override { return "Polygon"; }
 
-    void setFillColor(const QColor& color) override { fillColor = color; }
-    void setFilled(bool filled) override { isFilled = filled; }
-    QColor getFillColor() const override { return fillColor; }
-    bool isShapeFilled() const override { return isFilled; }
+    void setFillColor(const QColor& color) override { setStyle(style().withFill(color)); }
+    void setFilled(bool filled) override { setStyle(style().withFilled(filled)); }
+    QColor getFillColor() const override { return style().fill; }
+    bool isShapeFilled() const override { return style().filled; }
 
     QRect boundingRect() const override;
+    int32_t complexity() const override;
+    QPainterPath snapPath() const override;
     void addPoint(const QPoint& point);
     void finishShape();
 
@@ -30,9 +38,11 @@ public:
     void fromJson(const QJsonObject& obj) override;
 
 private:
+    // The outline and its holes as subpaths, before rotation.
+    QPainterPath path() const;
+
     QPolygon m_polygon;
-    QColor fillColor = Qt::transparent;
-    bool isFilled = false;
+    QList<QPolygon> m_holes;
 };
 
 #endif // POLYGONSHAPE_H
\ No newline at end of file
@@ -3,13 +3,14 @@
 
 #include "Shape.h"
 
-class RectangleShape : public Shape
+class RectangleShape final : public Shape
 {
 public:
     RectangleShape() = default;
     RectangleShape(const QPoint& topLeft, const QPoint& bottomRight);
     
     void draw(QPainter& painter) const override;
+    QPainterPath renderPath(qreal scale) const override;
     bool contains(const QPoint& pos) const override;
     void moveBy(int32_t dx, int32_t dy) override;
     void resize(const QSize& size) override;
@@ -17,10 +18,10 @@ public:
     void update(const QPoint& toPoint) override;
     QString name() const override;
 
-    void setFillColor(const QColor& color) override { fillColor = color; }
-    void setFilled(bool filled) override { isFilled = filled; }
-    QColor getFillColor() const override { return fillColor; }
-    bool isShapeFilled() const override { return isFilled; }
+    void setFillColor(const QColor& color) override { setStyle(style().withFill(color)); }
+    void setFilled(bool filled) override { setStyle(style().withFilled(filled)); }
+    QColor getFillColor() const override { return style().fill; }
+    bool isShapeFilled() const override { return style().filled; }
     
     QRect boundingRect() const override;
 
@@ -32,8 +33,6 @@ public:
 private:
     QPoint m_topLeft;
     QPoint m_bottomRight;
-    QColor fillColor;
-    bool isFilled;
 
 
     int m_velocityY = -3;
@@ -4,12 +4,13 @@
 #include "../Shapes/Shape.h"
 #include <QPolygon>
 
-class RegularPolygonShape : public Shape {
+class RegularPolygonShape final : public Shape {
 public:
     RegularPolygonShape() = default;
     RegularPolygonShape(const QPoint& center, int radius, int sides);
 
     void draw(QPainter& painter) const override;
+    QPainterPath renderPath(qreal scale) const override;
     bool contains(const QPoint& pos) const override;
     void moveBy(int32_t dx, int32_t dy) override;
     void resize(const QSize& size) override;
@@ -17,10 +18,10 @@ public:
     void update(const QPoint& toPoint) override;
     QString name() const override { return "RegularPolygon"; }
 
-    void setFillColor(const QColor& color) override { fillColor = color; }
-    void setFilled(bool filled) override { isFilled = filled; }
-    QColor getFillColor() const override { return fillColor; }
-    bool isShapeFilled() const override { return isFilled; }
+    void setFillColor(const QColor& color) override { setStyle(style().withFill(color)); }
+    void setFilled(bool filled) override { setStyle(style().withFilled(filled)); }
+    QColor getFillColor() const override { return style().fill; }
+    bool isShapeFilled() const override { return style().filled; }
 
     void setSides(int32_t sides);
     int getSides() const { return m_sides; }
@@ -30,15 +31,24 @@ public:
     QJsonObject toJson() const override;
     void fromJson(const QJsonObject& obj) override;
 
+    // Vertex directions of a polygon with this many sides, radius 1 and
+    // the first vertex at angle zero. Common counts come from constexpr
+    // tables, others are computed once and kept for the program's life.
+    struct UnitVertex {
+        double x;
+        double y;
+    };
+    static const UnitVertex* unitPolygon(int32_t sides);
+
 private:
+    // Places the unit vertices at the current centre and radius.
     void updatePolygon();
 
     QPoint m_center;
     int32_t m_radius = 0;
     int32_t m_sides = 5;
+    const UnitVertex* m_unit = unitPolygon(5);
     QPolygon m_polygon;
-    QColor fillColor = Qt::transparent;
-    bool isFilled = false;
 };
 
 #endif // REGULARPOLYGONSHAPE_H
\ No newline at end of file
@@ -6,18 +6,24 @@
 #include <QColor>
 #include <QPoint>
 #include <QRect>
+#include <QVector>
 
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QPainterPath>
+#include <atomic>
+#include "ShapeStyle.h"
 
 class Shape {
 public:
     virtual ~Shape() = default;
 
     virtual void draw(QPainter& painter) const = 0;
+    // Draws the shape as seen at the given device scale. Shapes may use
+    // cheaper geometry as long as the result stays within a pixel.
+    virtual void drawLod(QPainter& painter, qreal scale) const { Q_UNUSED(scale); draw(painter); }
     virtual bool contains(const QPoint& pos) const = 0;
     virtual void moveBy(int32_t dx, int32_t dy) = 0;
     virtual void resize(const QSize& size) = 0;
@@ -25,15 +31,15 @@ public:
     virtual void update(const QPoint& toPoint) = 0;
     virtual QString name() const = 0;
 
-    virtual void setColor(const QColor& color) { this->color = color; }
-    virtual void setPenWidth(int32_t width) { penWidth = width; }
+    virtual void setColor(const QColor& color) { setStyle(m_style->withStroke(color)); }
+    virtual void setPenWidth(int32_t width) { setStyle(m_style->withWidth(width)); }
     virtual void setRotation(double angle) { rotation_ = angle; }
     virtual void setAnimated(bool flag) { m_animated = flag; }
     virtual void setFillColor(const QColor& color) { Q_UNUSED(color); }
     virtual void setFilled(bool filled) { Q_UNUSED(filled); }
 
-    virtual QColor getColor() const { return color; }
-    virtual int32_t getPenWidth() const { return penWidth; }
+    virtual QColor getColor() const { return m_style->stroke; }
+    virtual int32_t getPenWidth() const { return m_style->width; }
     virtual double getRotation() const { return rotation_; }
     virtual bool isAnimated() const { return m_animated; }
     virtual double rotation() const {return rotation_;}
@@ -41,18 +47,107 @@ public:
     virtual bool isShapeFilled() const { return false; }
 
     virtual QRect boundingRect() const = 0;
+    // Bounds of everything the shape paints, effects included.
+    QRect renderBounds() const {
+        const int32_t margin = m_style->effectMargin();
+        return boundingRect().adjusted(-margin, -margin, margin, margin);
+    }
 
     virtual QJsonObject toJson() const = 0;
     virtual void fromJson(const QJsonObject& obj) = 0;
 
     virtual void animateStep() {}
+    // Rough cost of drawing the shape, in vertices.
+    virtual int32_t complexity() const { return 1; }
 
+    // World-space geometry and style for the batched render path. Shapes
+    // that need more than one pen or brush return an empty path and are
+    // drawn through drawLod() instead.
+    virtual QPainterPath renderPath(qreal scale) const { Q_UNUSED(scale); return QPainterPath(); }
+    virtual QPen renderPen() const { return m_style->pen(); }
+    virtual QBrush renderBrush() const { return m_style->brush(); }
+    // World-space outline whose vertices and segment midpoints other
+    // shapes snap to.
+    virtual QPainterPath snapPath() const { return renderPath(1.0); }
+
+    // Interned stroke and fill; equal styles share one entry.
+    const ShapeStyle& style() const { return *m_style; }
+    void setStyle(const ShapeStyle& style) { m_style = ShapeStyle::intern(style); }
+
+    // Changes whenever the canvas edits the shape. Values are unique across
+    // all shapes, so caches can key on (pointer, version) safely.
+    quint64 version() const { return m_version; }
+    void markChanged() { m_version = nextVersion(); }
 
 protected:
-    QColor color = Qt::black;
-    int32_t penWidth = 2;
+    QPainterPath rotatedAbout(const QPainterPath& path, const QPointF& center) const {
+        if (rotation_ == 0.0) return path;
+        QTransform transform;
+        transform.translate(center.x(), center.y());
+        transform.rotate(rotation_);
+        transform.translate(-center.x(), -center.y());
+        return transform.map(path);
+    }
+
+    int32_t halfPenWidth() const { return m_style->width / 2; }
+    // Geometry bounds grown by half the pen width.
+    QRect strokedBounds(const QRectF& bounds) const {
+        const int32_t half = halfPenWidth();
+        return bounds.adjusted(-half, -half, half, half).toRect();
+    }
+    void writeStyle(QJsonObject& obj) const { ShapeStyle::write(m_style, obj); }
+    void readStyle(const QJsonObject& obj) { m_style = ShapeStyle::read(obj); }
+    // Style and rotation, saved alike by every styled shape.
+    void writeCommon(QJsonObject& obj) const {
+        writeStyle(obj);
+        obj["rotation"] = rotation_;
+    }
+    void readCommon(const QJsonObject& obj) {
+        readStyle(obj);
+        rotation_ = obj["rotation"].toDouble();
+    }
+
+    // Point runs are saved as arrays of {"x", "y"} objects.
+    template <typename Points>
+    static QJsonArray writePoints(const Points& points) {
+        QJsonArray array;
+        for (const auto& point : points) {
+            array.append(QJsonObject{{"x", point.x()}, {"y", point.y()}});
+        }
+        return array;
+    }
+    static QVector<QPoint> readPoints(const QJsonValue& value) {
+        const QJsonArray array = value.toArray();
+        QVector<QPoint> points;
+        points.reserve(array.size());
+        for (const QJsonValue& point : array) {
+            const QJsonObject obj = point.toObject();
+            points.append(QPoint(obj["x"].toInt(), obj["y"].toInt()));
+        }
+        return points;
+    }
+    static QVector<QPointF> readPointsF(const QJsonValue& value) {
+        const QJsonArray array = value.toArray();
+        QVector<QPointF> points;
+        points.reserve(array.size());
+        for (const QJsonValue& point : array) {
+            const QJsonObject obj = point.toObject();
+            points.append(QPointF(obj["x"].toDouble(), obj["y"].toDouble()));
+        }
+        return points;
+    }
+
     double rotation_ = 0.0;
     bool m_animated = false;
+
+private:
+    static quint64 nextVersion() {
+        static std::atomic<quint64> counter{0};
+        return ++counter;
+    }
+
+    ShapeStyle::Handle m_style;
+    quint64 m_version = nextVersion();
 };
 
 #endif // SHAPE_H
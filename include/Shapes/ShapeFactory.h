@@ -0,0 +1,89 @@
+#ifndef SHAPEFACTORY_H
+#define SHAPEFACTORY_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QPoint>
+#include <QString>
+#include <memory>
+#include <memory_resource>
+#include <typeinfo>
+#include <utility>
+#include "Shape.h"
+
+// The one list of shape types: the "type" tag of saved documents, the
+// class behind it and the drawing tool that starts one. Lookups go through
+// hashes built once from that list, so loading does no string chains.
+namespace ShapeFactory {
+    struct TypeInfo {
+        QString name;
+        const std::type_info* type;
+        std::shared_ptr<Shape> (*create)();
+        // ToolBar::Tool drawing this type, or -1 when no tool does.
+        int32_t tool;
+        // Fresh shape for a drag starting at the point; null when tool is -1.
+        std::shared_ptr<Shape> (*begin)(const QPoint& start);
+        // Copy-constructs a shape of this type.
+        std::shared_ptr<Shape> (*copy)(const Shape& shape);
+    };
+
+    const QList<TypeInfo>& types();
+    // Return nullptr for unregistered names, classes or tools.
+    const TypeInfo* find(const QString& name);
+    const TypeInfo* find(const Shape& shape);
+    const TypeInfo* findTool(int32_t tool);
+
+    // Returns nullptr for unknown types.
+    std::shared_ptr<Shape> create(const QString& type);
+    // Starts a shape for a drawing tool; nullptr for tools that draw none.
+    std::shared_ptr<Shape> begin(int32_t tool, const QPoint& start);
+
+    QJsonObject toJson(const Shape& shape);
+    std::shared_ptr<Shape> fromJson(const QJsonObject& obj);
+
+    // Copy through the class's copy constructor, as a new shape with its
+    // own version. A group's copy shares its children; shared shapes are
+    // replaced, never edited, so that is safe.
+    std::shared_ptr<Shape> clone(const Shape& shape);
+
+    // Pool that the open document's shapes, their shared_ptr control
+    // blocks and their point streams come from. Each shape's control
+    // block holds the pool, so it is released in one go once the
+    // document, its undo history, caches and tile jobs have all let go of
+    // its shapes. Thread-safe: tile workers can drop the last reference.
+    std::shared_ptr<std::pmr::memory_resource> shapeResource();
+    // Starts a fresh pool for the shapes made from now on, when a
+    // document is cleared or loaded.
+    void resetShapeResource();
+
+    // Allocates from a pool and keeps it alive while any copy exists.
+    template <typename T>
+    class PoolAllocator
+    {
+    public:
+        using value_type = T;
+
+        explicit PoolAllocator(std::shared_ptr<std::pmr::memory_resource> pool) : m_pool(std::move(pool)) {}
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>& other) : m_pool(other.pool()) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(m_pool->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T* p, size_t n) { m_pool->deallocate(p, n * sizeof(T), alignof(T)); }
+
+        const std::shared_ptr<std::pmr::memory_resource>& pool() const { return m_pool; }
+        template <typename U>
+        bool operator==(const PoolAllocator<U>& other) const { return m_pool == other.pool(); }
+        template <typename U>
+        bool operator!=(const PoolAllocator<U>& other) const { return m_pool != other.pool(); }
+
+    private:
+        std::shared_ptr<std::pmr::memory_resource> m_pool;
+    };
+
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(PoolAllocator<T>(shapeResource()), std::forward<Args>(args)...);
+    }
+}
+
+#endif // SHAPEFACTORY_H
@@ -0,0 +1,163 @@
+#ifndef SHAPESTYLE_H
+#define SHAPESTYLE_H
+
+#include <QBrush>
+#include <QColor>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QPen>
+#include <QPointF>
+#include <utility>
+
+// Stroke, fill and effects of a shape. Styles are interned: equal styles
+// share one immutable entry in a process-wide table, so shapes hold a
+// 32-bit id of it, two styles compare by id, and pens and brushes are
+// built once per entry. Entries are reference counted and their slots
+// reused once no handle refers to them, so the table stays as large as
+// the styles in use, however many an animation passes through.
+class ShapeStyle
+{
+public:
+    enum Gradient { NoGradient, LinearGradient, RadialGradient };
+
+    // Counted reference to an interned entry; the default style when
+    // default-constructed.
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(const Handle& other) : m_id(other.m_id) { retain(m_id); }
+        Handle(Handle&& other) noexcept : m_id(other.m_id) { other.m_id = 0; }
+        Handle& operator=(const Handle& other) {
+            retain(other.m_id);
+            release(m_id);
+            m_id = other.m_id;
+            return *this;
+        }
+        Handle& operator=(Handle&& other) noexcept {
+            std::swap(m_id, other.m_id);
+            return *this;
+        }
+        ~Handle() { release(m_id); }
+
+        quint32 id() const { return m_id; }
+        const ShapeStyle& operator*() const { return at(m_id); }
+        const ShapeStyle* operator->() const { return &at(m_id); }
+        bool operator==(const Handle& other) const { return m_id == other.m_id; }
+
+    private:
+        friend class ShapeStyle;
+        // Takes over a reference already counted for id.
+        explicit Handle(quint32 id) : m_id(id) {}
+
+        quint32 m_id = 0;
+    };
+
+    QColor stroke = Qt::black;
+    int32_t width = 2;
+    QColor fill = Qt::transparent;
+    bool filled = false;
+    // A gradient fill runs from fill to fillEnd across the shape's bounds;
+    // a linear one at gradientAngle degrees, clockwise from left to right.
+    Gradient gradient = NoGradient;
+    QColor fillEnd = Qt::transparent;
+    qreal gradientAngle = 0.0;
+    // Gaussian blur of the whole shape, as a standard deviation in world
+    // units.
+    qreal blur = 0.0;
+    // Drop shadow, off while the colour is transparent.
+    QColor shadow = Qt::transparent;
+    QPointF shadowOffset;
+    qreal shadowBlur = 0.0;
+
+    // The shared entry equal to style.
+    static Handle intern(const ShapeStyle& style);
+    static Handle defaultStyle() { return Handle(); }
+
+    ShapeStyle withStroke(const QColor& color) const { ShapeStyle s = *this; s.stroke = color; return s; }
+    ShapeStyle withWidth(int32_t w) const { ShapeStyle s = *this; s.width = w; return s; }
+    ShapeStyle withFill(const QColor& color) const { ShapeStyle s = *this; s.fill = color; return s; }
+    ShapeStyle withFilled(bool f) const { ShapeStyle s = *this; s.filled = f; return s; }
+    ShapeStyle withGradient(Gradient kind, const QColor& end, qreal angle) const {
+        ShapeStyle s = *this; s.gradient = kind; s.fillEnd = end; s.gradientAngle = angle; return s;
+    }
+    ShapeStyle withBlur(qreal radius) const { ShapeStyle s = *this; s.blur = radius; return s; }
+    ShapeStyle withShadow(const QColor& color, const QPointF& offset, qreal radius) const {
+        ShapeStyle s = *this; s.shadow = color; s.shadowOffset = offset; s.shadowBlur = radius; return s;
+    }
+
+    bool hasEffects() const { return blur > 0.0 || shadow.alpha() > 0; }
+    // How far effects reach beyond the shape's bounds, in world units.
+    int32_t effectMargin() const;
+
+    // Built on interning; shapes returning these let batches compare
+    // pens and brushes by their shared data. A gradient brush is built
+    // once per style in object coordinates, so every shape with the style
+    // shares its stops and the colour table the paint engine caches for
+    // them.
+    const QPen& pen() const { return m_pen; }
+    const QPen& roundPen() const { return m_roundPen; }
+    const QBrush& brush() const { return m_brush; }
+
+    bool operator==(const ShapeStyle& other) const;
+
+    // Saves a "style" index into the current palette, or the style
+    // inline when there is none. Loading accepts both, plus the older
+    // per-shape keys.
+    static void write(const Handle& style, QJsonObject& obj);
+    static Handle read(const QJsonObject& obj);
+
+private:
+    struct Table;
+    static Table& table();
+    // Entry lookup is lock-free; slots never move while referenced.
+    static const ShapeStyle& at(quint32 id);
+    static void retain(quint32 id);
+    static void release(quint32 id);
+
+    void writeFields(QJsonObject& obj) const;
+    static ShapeStyle readFields(const QJsonObject& obj);
+    // Builds the pen and brush of a new entry.
+    void build();
+    QBrush makeBrush() const;
+
+    QPen m_pen;
+    QPen m_roundPen;
+    QBrush m_brush;
+
+    friend class StylePalette;
+};
+
+// Numbers the styles of one document so each is saved once. While a
+// palette is current, shapes save and load an index into it.
+class StylePalette
+{
+public:
+    int32_t indexOf(const ShapeStyle::Handle& style);
+    // The default style for indices out of range.
+    ShapeStyle::Handle at(int32_t index) const;
+
+    QJsonArray toJson() const;
+    void fromJson(const QJsonArray& array);
+
+    static StylePalette* current();
+
+    // Makes a palette current on this thread for the scope's lifetime.
+    class Scope
+    {
+    public:
+        explicit Scope(StylePalette& palette);
+        ~Scope();
+
+    private:
+        StylePalette* m_previous;
+    };
+
+private:
+    QList<ShapeStyle::Handle> m_styles;
+    QHash<quint32, int32_t> m_indices;
+};
+
+#endif // SHAPESTYLE_H
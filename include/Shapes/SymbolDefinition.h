@@ -0,0 +1,60 @@
+#ifndef SYMBOLDEFINITION_H
+#define SYMBOLDEFINITION_H
+
+#include <QHash>
+#include <QImage>
+#include <QJsonObject>
+#include <QList>
+#include <QPainterPath>
+#include <QString>
+#include <memory>
+#include <mutex>
+#include "Shape.h"
+
+// Geometry shared by any number of InstanceShapes. The geometry is never
+// edited after creation, so the render caches below never go stale.
+class SymbolDefinition
+{
+public:
+    // Raster caches stop at this many pixels per side.
+    static constexpr int32_t MaxRasterSize = 1024;
+    static constexpr int32_t RasterMargin = 4;
+
+    // Registers the symbol under id, or under a fresh id when empty.
+    static std::shared_ptr<SymbolDefinition> create(std::shared_ptr<Shape> geometry, const QString& id = QString());
+    // Looks up a live symbol by id; nullptr once no instance uses it.
+    static std::shared_ptr<SymbolDefinition> find(const QString& id);
+
+    // Symbols referenced by shapes (through groups and nested symbols),
+    // dependencies first, each listed once.
+    static QList<std::shared_ptr<SymbolDefinition>> collect(const QList<std::shared_ptr<Shape>>& shapes);
+
+    QString id() const { return m_id; }
+    const Shape& geometry() const { return *m_geometry; }
+    QRect bounds() const { return m_bounds; }
+    QRect rasterRect() const { return m_bounds.adjusted(-RasterMargin, -RasterMargin, RasterMargin, RasterMargin); }
+
+    // Single-style render path at the level for scale; empty when the
+    // geometry needs more than one pen or brush.
+    QPainterPath path(qreal scale) const;
+    // The geometry rendered at the level for scale; null when too large.
+    QImage raster(qreal scale) const;
+
+    QJsonObject toJson() const;
+    static std::shared_ptr<SymbolDefinition> fromJson(const QJsonObject& obj);
+
+private:
+    SymbolDefinition(std::shared_ptr<Shape> geometry, const QString& id);
+
+    static constexpr int32_t MaxCachedRasters = 3;
+
+    QString m_id;
+    std::shared_ptr<const Shape> m_geometry;
+    QRect m_bounds;
+
+    mutable std::mutex m_mutex;
+    mutable QHash<int32_t, QPainterPath> m_paths;
+    mutable QHash<int32_t, QImage> m_rasters;
+};
+
+#endif // SYMBOLDEFINITION_H
@@ -0,0 +1,62 @@
+#ifndef TEXTSHAPE_H
+#define TEXTSHAPE_H
+
+#include "Shape.h"
+#include <QFont>
+#include <QGlyphRun>
+#include <QList>
+#include <QVector>
+
+// A block of unwrapped text, one line per paragraph. The text is shaped
+// once whenever content or font change; moving and rotating reuse the
+// cached glyph runs, so drawing never lays text out again.
+class TextShape final : public Shape
+{
+public:
+    static constexpr int32_t DefaultPixelSize = 24;
+    // Below this many device pixels the lines are drawn as plain bars.
+    static constexpr qreal MinReadableSize = 3.0;
+
+    TextShape();
+    TextShape(const QPoint& position, const QString& text);
+
+    void draw(QPainter& painter) const override;
+    void drawLod(QPainter& painter, qreal scale) const override;
+    bool contains(const QPoint& pos) const override;
+    void moveBy(int32_t dx, int32_t dy) override;
+    void resize(const QSize& size) override;
+    void rotate(double angle) override;
+    void update(const QPoint& toPoint) override;
+    QString name() const override { return "Text"; }
+
+    QRect boundingRect() const override;
+    int32_t complexity() const override { return m_text.size(); }
+
+    QJsonObject toJson() const override;
+    void fromJson(const QJsonObject& obj) override;
+
+    QString text() const { return m_text; }
+    void setText(const QString& text);
+    QFont font() const { return m_font; }
+    void setFont(const QFont& font);
+
+private:
+    struct Line {
+        QList<QGlyphRun> runs;
+        // Relative to m_position.
+        QRectF box;
+    };
+
+    void relayout();
+    QTransform rotationTransform() const;
+    void drawLines(QPainter& painter, bool bars) const;
+
+    QString m_text;
+    QFont m_font;
+    QPoint m_position;
+
+    QVector<Line> m_lines;
+    QRectF m_extent;
+};
+
+#endif // TEXTSHAPE_H
@@ -0,0 +1,67 @@
+#ifndef SNAPENGINE_H
+#define SNAPENGINE_H
+
+#include <QHash>
+#include <QList>
+#include <QPointF>
+#include <QSet>
+#include <QVector>
+#include "Shapes/Shape.h"
+#include "SpatialIndex.h"
+
+// Finds the closest snap target to a point: grid intersections, shape
+// vertices and segment midpoints, and bounding-box corners, edge midpoints
+// and centres. Shapes near the point come from the layers' spatial
+// indexes. Their candidates are cached per shape version and sorted by x,
+// so a query only visits the points within reach of the cursor.
+class SnapEngine
+{
+public:
+    enum Target {
+        Grid = 0x1,
+        Vertices = 0x2,
+        Midpoints = 0x4,
+        Bounds = 0x8,
+        Centers = 0x10,
+        Objects = Vertices | Midpoints | Bounds | Centers
+    };
+
+    // World units between grid lines.
+    static constexpr int32_t GridSize = 10;
+    // Paths with more elements than this only offer their bounds.
+    static constexpr int32_t MaxPathElements = 512;
+
+    struct Hit {
+        QPointF pos;
+        Target kind = Grid;
+    };
+
+    int32_t targets() const { return m_targets; }
+    void setTargets(int32_t targets) { m_targets = targets; }
+
+    // The closest enabled target within radius of pos. Shape targets win
+    // over the grid; shapes in exclude are skipped.
+    bool snap(const QPointF& pos, qreal radius, const QList<const SpatialIndex*>& indexes,
+              const QSet<const Shape*>& exclude, Hit& hit);
+
+private:
+    struct Candidate {
+        QPointF pos;
+        Target kind;
+    };
+
+    struct Entry {
+        quint64 version = 0;
+        QVector<Candidate> candidates;
+    };
+
+    static QVector<Candidate> collect(const Shape& shape);
+    const QVector<Candidate>& candidatesOf(const Shape& shape);
+    // Drops entries of shapes no longer in any index.
+    void prune(const QList<const SpatialIndex*>& indexes);
+
+    int32_t m_targets = Objects;
+    QHash<const Shape*, Entry> m_entries;
+};
+
+#endif // SNAPENGINE_H
@@ -0,0 +1,70 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QRect>
+#include <QVector>
+#include <memory>
+#include "Shapes/Shape.h"
+
+// Uniform grid over shape bounding rects. Queries return shapes in
+// stacking order (bottom first), so results can be painted directly.
+class SpatialIndex
+{
+public:
+    static constexpr int32_t CellSize = 512;
+    // Shapes covering more cells than this are kept in a separate list
+    // instead of being copied into every cell.
+    static constexpr int32_t MaxCellsPerShape = 64;
+    // Vertex markers and caps can stick out slightly past boundingRect().
+    static constexpr int32_t BoundsMargin = 4;
+
+    void clear();
+    void rebuild(const QList<std::shared_ptr<Shape>>& shapes);
+
+    // Adds the shape on top of everything already indexed.
+    void insert(const std::shared_ptr<Shape>& shape);
+    void update(const Shape* shape);
+    void remove(const Shape* shape);
+    // Swaps a shape for the pieces it was split into; they share its place
+    // in the stacking order.
+    void replace(const Shape* shape, const QList<std::shared_ptr<Shape>>& pieces);
+    // Hidden shapes keep their place in the stacking order but are left
+    // out of queries, e.g. while the canvas draws them some other way.
+    void setHidden(const Shape* shape, bool hidden);
+
+    bool contains(const Shape* shape) const { return m_entries.contains(shape); }
+    QRect bounds(const Shape* shape) const;
+    QRect boundingRect() const;
+    int32_t size() const { return m_entries.size(); }
+    // Sorts shapes into stacking order; unindexed shapes go last.
+    void sortByOrder(QList<std::shared_ptr<Shape>>& shapes) const;
+
+    // Optionally also returns each hit's indexed (margin-padded) bounds.
+    QList<std::shared_ptr<Shape>> query(const QRect& area, QVector<QRect>* bounds = nullptr) const;
+    QList<std::shared_ptr<Shape>> query(const QPoint& pos) const;
+
+private:
+    struct Entry {
+        std::shared_ptr<Shape> shape;
+        QRect bounds;
+        int32_t order = 0;
+        bool oversized = false;
+        bool hidden = false;
+    };
+
+    static quint64 cellKey(int32_t cx, int32_t cy);
+    static QRect cellRange(const QRect& bounds);
+
+    void add(const std::shared_ptr<Shape>& shape, int32_t order);
+    void link(const Shape* shape, Entry& entry);
+    void unlink(const Shape* shape, const Entry& entry);
+
+    QHash<const Shape*, Entry> m_entries;
+    QHash<quint64, QVector<const Shape*>> m_cells;
+    QVector<const Shape*> m_oversized;
+    int32_t m_nextOrder = 0;
+};
+
+#endif // SPATIALINDEX_H
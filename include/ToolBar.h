@@ -19,7 +19,10 @@ public:
         RectangleTool,
         FreehandTool,
         PolygonTool,
-        RegularPolygonTool
+        RegularPolygonTool,
+        EraserTool,
+        FillTool,
+        TextTool
     };
 
     explicit ToolBar(QWidget* parent = nullptr);
@@ -80,6 +83,9 @@ private:
     QAction* m_freehandAction;
     QAction* m_polygonAction;
     QAction* m_regularPolygonAction;
+    QAction* m_eraserAction;
+    QAction* m_fillAction;
+    QAction* m_textAction;
     
     // Other actions
     QAction* m_undoAction;
@@ -0,0 +1,40 @@
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+#include <QTransform>
+
+// Maps between document (world) and widget (device) coordinates:
+// device = world * zoom + offset.
+class Viewport
+{
+public:
+    static constexpr qreal MinZoom = 1.0 / 32.0;
+    static constexpr qreal MaxZoom = 64.0;
+
+    qreal zoom() const { return m_zoom; }
+    QPointF offset() const { return m_offset; }
+    QTransform transform() const;
+
+    QPointF mapToWorld(const QPointF& devicePos) const;
+    QRectF mapToWorld(const QRectF& deviceRect) const;
+    QPointF mapFromWorld(const QPointF& worldPos) const;
+    QRectF mapFromWorld(const QRectF& worldRect) const;
+
+    void setZoom(qreal zoom);
+    void zoomAt(const QPointF& devicePos, qreal factor);
+    void panBy(const QPointF& deviceDelta);
+    void fit(const QRectF& worldRect, const QSize& viewportSize);
+
+    // Power-of-two resolution level whose tiles are at least as sharp as
+    // the current zoom: 2^level >= zoom.
+    int32_t level() const;
+
+private:
+    qreal m_zoom = 1.0;
+    QPointF m_offset;
+};
+
+#endif // VIEWPORT_H
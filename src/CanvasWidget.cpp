@@ -3,20 +3,36 @@
 #include "../include/Shapes/CircleShape.h"
 #include "../include/Shapes/RectangleShape.h"
 #include "../include/Shapes/FreehandShape.h"
+#include "../include/Shapes/CurveShape.h"
 #include "../include/Shapes/PolygonShape.h"
 #include "../include/Shapes/RegularPolygonShape.h"
+#include "../include/Shapes/TextShape.h"
+#include "../include/Shapes/GroupShape.h"
+#include "../include/Shapes/InstanceShape.h"
+#include "../include/Shapes/ShapeFactory.h"
+#include "../include/Rendering/FloodFill.h"
+#include "../include/Rendering/CurveFit.h"
+#include "../include/Rendering/Effects.h"
 #include <QPainter>
 #include <QMouseEvent>
 #include <QFile>
 #include <QDataStream>
 #include <QMessageBox>
+#include <QInputDialog>
+#include <QHash>
+#include <QSet>
+#include <QNativeGestureEvent>
+#include <QWheelEvent>
+#include <QtMath>
+#include <limits>
 
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
 
-CanvasWidget::CanvasWidget(QWidget *parent) : QWidget(parent)
+CanvasWidget::CanvasWidget(QWidget *parent)
+    : QWidget(parent), m_backgroundTiles(m_backgroundIndex, m_renderer)
 {
     setAttribute(Qt::WA_StaticContents);
     setMouseTracking(true);
@@ -24,15 +40,21 @@ CanvasWidget::CanvasWidget(QWidget *parent) : QWidget(parent)
     m_originalSize = QSize(800, 600);
     resize(m_originalSize);
 
+    connect(&m_backgroundTiles, &TileCache::tilesReady, this, QOverload<>::of(&QWidget::update));
+    connect(ImagePyramid::notifier(), &ImagePyramidNotifier::loaded, this, &CanvasWidget::imageLoaded);
+    connect(ImagePyramid::notifier(), &ImagePyramidNotifier::regionLoaded, this, &CanvasWidget::imageRegionLoaded);
+    m_layers.append(createLayer(tr("Layer 1")));
+
     connect(&m_animationTimer, &QTimer::timeout, this, [this]() {
-        bool anyAnimated = false;
-        for (const auto& shape : m_shapes) {
-            if (shape->isAnimated()) {
-                shape->animateStep();
-                anyAnimated = true;
+        for (const auto& layer : m_layers) {
+            QList<std::shared_ptr<Shape>> animated;
+            for (const auto& shape : layer->shapes) {
+                if (shape->isAnimated()) animated.append(shape);
+            }
+            if (!animated.isEmpty()) {
+                modifyShapes(*layer, animated, [](Shape& s) { s.animateStep(); });
             }
         }
-        if (anyAnimated) update();
     });
     m_animationTimer.start(30);
 }
@@ -41,7 +63,7 @@ void CanvasWidget::setTool(ToolBar::Tool tool)
 {
     m_currentTool = tool;
     if (tool != ToolBar::SelectTool){
-        m_selectedShape = nullptr;
+        setSelection({});
     }
     update();
 }
@@ -49,117 +71,222 @@ void CanvasWidget::setTool(ToolBar::Tool tool)
 void CanvasWidget::setPenColor(const QColor &color)
 {
     m_penColor = color;
-    if (m_selectedShape) {
-        m_selectedShape->setColor(color);
-        updateModification(true);
-        update();
-    }
+    editSelection([&color](Shape& s) { s.setColor(color); });
 }
 
 void CanvasWidget::setPenWidth(int32_t width)
 {
     m_penWidth = width;
-    if (m_selectedShape) {
-        m_selectedShape->setPenWidth(width);
-        updateModification(true);
-        update();
-    }
+    editSelection([width](Shape& s) { s.setPenWidth(width); });
 }
 
 void CanvasWidget::paintEvent(QPaintEvent *event)
 {
     QPainter painter(this);
-    painter.fillRect(rect(), Qt::white);
+    m_backgroundTiles.paint(painter, m_viewport, size());
+    if (m_background) {
+        // Read the scan's detail a screen ahead in every direction.
+        const QRectF visible = m_viewport.mapToWorld(QRectF(rect()));
+        m_background->prefetch(visible.adjusted(-visible.width(), -visible.height(), visible.width(), visible.height()),
+                               std::ldexp(1.0, m_viewport.level()));
+    }
+    for (const auto& layer : m_layers) {
+        if (!layer->visible) continue;
+        painter.setOpacity(layer->opacity);
+        layer->tiles.paint(painter, m_viewport, size());
+    }
+    painter.setOpacity(1.0);
+    if (m_snap.targets() & SnapEngine::Grid) {
+        drawGrid(painter);
+    }
 
-    painter.save();
-    painter.scale(m_scaleFactor, m_scaleFactor);
+    painter.setTransform(m_viewport.transform());
+    if (m_dragSprite) {
+        m_dragSprite->draw(painter);
+    }
+    drawSelection(painter);
+
+    if (m_dragMode == MarqueeDrag && !m_band.isEmpty()) {
+        QPen pen(Qt::DashLine);
+        pen.setColor(Qt::darkGray);
+        pen.setCosmetic(true);
+        painter.setPen(pen);
+        painter.setBrush(QColor(0, 120, 215, 32));
+        painter.drawPolygon(m_band);
+    }
 
-    if (!m_backgroundImage.isNull()) {
-        painter.drawPixmap(0, 0, m_backgroundImage.scaled(size() / m_scaleFactor));
+    if (m_currentShape) {
+        m_currentShape->draw(painter);
     }
+    drawSnapHit(painter);
+}
 
-    for (const auto &shape : m_shapes) {
-        shape->draw(painter);
-        
-        if (shape == m_selectedShape) {
-            QRect rect = shape->boundingRect();
-            QPen pen(Qt::DashLine);
-            pen.setColor(Qt::blue);
-            pen.setWidth(1);
-            painter.setPen(pen);
-            painter.setBrush(Qt::NoBrush);
-            painter.drawRect(rect.adjusted(-2, -2, 2, 2));
-        
-            // Resize handle (bottom-right)
-            painter.setBrush(Qt::blue);
-            painter.drawRect(QRect(rect.bottomRight() - QPoint(5, 5), QSize(10, 10)));
-        
-            // Rotate handle (top-center)
-            QPoint topCenter(rect.center().x(), rect.top() - 20);
-            painter.setBrush(Qt::red);
-            painter.drawEllipse(topCenter, 5, 5);
-        }
-        
+void CanvasWidget::drawGrid(QPainter& painter) const
+{
+    // Skip lines that would crowd closer than MinGridSpacing.
+    qreal step = SnapEngine::GridSize;
+    while (step * m_viewport.zoom() < MinGridSpacing) step *= 2;
+
+    const QRectF visible = m_viewport.mapToWorld(QRectF(rect()));
+    QVector<QLineF> lines;
+    for (qreal x = std::floor(visible.left() / step) * step; x <= visible.right(); x += step) {
+        lines.append(QLineF(m_viewport.mapFromWorld(QPointF(x, visible.top())),
+                            m_viewport.mapFromWorld(QPointF(x, visible.bottom()))));
+    }
+    for (qreal y = std::floor(visible.top() / step) * step; y <= visible.bottom(); y += step) {
+        lines.append(QLineF(m_viewport.mapFromWorld(QPointF(visible.left(), y)),
+                            m_viewport.mapFromWorld(QPointF(visible.right(), y))));
     }
+
+    painter.save();
+    painter.setPen(QPen(QColor(0, 0, 0, 24), 0));
+    painter.drawLines(lines);
     painter.restore();
+}
 
-    if (m_currentShape) {
-        painter.save();
-        painter.scale(m_scaleFactor, m_scaleFactor);
-        m_currentShape->draw(painter);
-        painter.restore();
+void CanvasWidget::drawSnapHit(QPainter& painter) const
+{
+    if (!m_hasSnapHit) return;
+
+    painter.save();
+    painter.resetTransform();
+    painter.setPen(QPen(QColor(255, 128, 0), 0));
+    painter.setBrush(Qt::NoBrush);
+    const QPointF pos = m_viewport.mapFromWorld(m_snapHit.pos);
+    switch (m_snapHit.kind) {
+    case SnapEngine::Grid:
+        painter.drawLine(pos - QPointF(4, 0), pos + QPointF(4, 0));
+        painter.drawLine(pos - QPointF(0, 4), pos + QPointF(0, 4));
+        break;
+    case SnapEngine::Midpoints:
+    case SnapEngine::Centers:
+        painter.drawEllipse(pos, 4, 4);
+        break;
+    default:
+        painter.drawRect(QRectF(pos - QPointF(4, 4), QSizeF(8, 8)));
+        break;
+    }
+    painter.restore();
+}
+
+void CanvasWidget::drawSelection(QPainter& painter) const
+{
+    QRect rect = selectionBounds();
+    if (rect.isNull()) return;
+
+    painter.save();
+    if (m_dragSprite) {
+        painter.setTransform(m_dragSprite->transform(), true);
+    }
+    QPen pen(Qt::DashLine);
+    pen.setColor(Qt::blue);
+    pen.setWidth(1);
+    painter.setPen(pen);
+    painter.setBrush(Qt::NoBrush);
+    if (m_selection.size() > 1 && m_selection.size() <= MaxOutlinedShapes) {
+        for (const auto& shape : m_selection) {
+            painter.drawRect(shape->boundingRect());
+        }
     }
+    painter.drawRect(rect.adjusted(-2, -2, 2, 2));
+
+    // Resize handle (bottom-right)
+    painter.setBrush(Qt::blue);
+    painter.drawRect(QRect(rect.bottomRight() - QPoint(5, 5), QSize(10, 10)));
+
+    // Rotate handle (top-center)
+    QPoint topCenter(rect.center().x(), rect.top() - 20);
+    painter.setBrush(Qt::red);
+    painter.drawEllipse(topCenter, 5, 5);
+    painter.restore();
 }
 
 void CanvasWidget::mousePressEvent(QMouseEvent *event)
 {
-    m_lastPoint = event->pos() / m_scaleFactor;
+    if (event->button() == Qt::MiddleButton) {
+        m_isPanning = true;
+        m_panOrigin = event->position();
+        setCursor(Qt::ClosedHandCursor);
+        return;
+    }
+
+    m_lastPoint = toWorld(event->position());
+    if (event->button() == Qt::LeftButton && snapsWhileDrawing()) {
+        m_lastPoint = snapPoint(m_lastPoint);
+    }
     if (event->button() == Qt::LeftButton && m_currentTool != ToolBar::PolygonTool) {
         
         if (m_currentTool == ToolBar::SelectTool) {
-            if (m_selectedShape) {
-                QRect rect = m_selectedShape->boundingRect();
+            const bool extend = event->modifiers() & Qt::ShiftModifier;
+            m_dragMode = NoDrag;
+            m_dragOrigin = m_lastPoint;
+
+            if (!m_selection.isEmpty() && !extend) {
+                QRect rect = selectionBounds();
                 QRect resizeHandle(rect.bottomRight() - QPoint(5, 5), QSize(10, 10));
                 QPoint rotateHandleCenter(rect.center().x(), rect.top() - 20);
                 QRect rotateHandle(rotateHandleCenter - QPoint(5, 5), QSize(10, 10));
 
                 if (resizeHandle.contains(m_lastPoint)) {
                     m_dragMode = ResizeDrag;
-                    return;
                 } else if (rotateHandle.contains(m_lastPoint)) {
                     m_dragMode = RotateDrag;
-                    return;
                 } else if (rect.contains(m_lastPoint)) {
                     m_dragMode = MoveDrag;
+                }
+                if (m_dragMode != NoDrag) {
+                    m_dragBounds = rect;
+                    m_dragDetached = false;
+                    beginSpriteDrag();
                     return;
                 }
             }
 
-            selectShapeAt(m_lastPoint);
-            if (m_selectedShape)
-                emit shapeSelected(m_selectedShape->name());
-            else
-                emit shapeSelected("");
-
-            m_dragMode = NoDrag;
-        } else {
+            int32_t hitLayer = m_activeLayer;
+            std::shared_ptr<Shape> hit = shapeAt(m_lastPoint, &hitLayer);
+            if (hit && hitLayer != m_activeLayer) {
+                // Picking a shape on another layer makes that layer current.
+                setActiveLayer(hitLayer);
+                setSelection({hit});
+            } else if (hit && extend) {
+                QList<std::shared_ptr<Shape>> selection = m_selection;
+                if (!selection.removeOne(hit)) selection.append(hit);
+                setSelection(selection);
+            } else if (hit) {
+                setSelection({hit});
+            } else {
+                // Empty space starts a rubber band; Alt draws a lasso.
+                if (!extend) setSelection({});
+                m_dragMode = MarqueeDrag;
+                m_lassoBand = event->modifiers() & Qt::AltModifier;
+                m_band = QPolygon() << m_lastPoint;
+            }
+        } else if (m_currentTool == ToolBar::TextTool) {
+            if (activeLayer().isEditable()) editText(m_lastPoint);
+        } else if (m_currentTool == ToolBar::FillTool) {
+            if (activeLayer().isEditable()) bucketFill(m_lastPoint);
+        } else if (m_currentTool == ToolBar::EraserTool) {
+            if (activeLayer().isEditable()) {
+                m_isErasing = true;
+                m_eraseChanged = false;
+                eraseAlong(m_lastPoint, m_lastPoint);
+            }
+        } else if (activeLayer().isEditable()) {
             m_isDrawing = true;
             m_currentShape = createShape(m_currentTool, m_lastPoint);
         }
     }
     else if (event->button() == Qt::RightButton) {
-        QPoint pos = event->pos() / m_scaleFactor;
-        for (auto it = m_shapes.rbegin(); it != m_shapes.rend(); ++it) {
-            if ((*it)->contains(pos)) {
-                (*it)->setAnimated(true);
-                return;
-            }
+        if (std::shared_ptr<Shape> hit = shapeAt(toWorld(event->position()))) {
+            hit->setAnimated(true);
+            return;
         }
     }
 
     if (m_currentTool == ToolBar::PolygonTool) {
         if (event->button() == Qt::LeftButton) {
             if (!m_isDrawing) {
+                if (!activeLayer().isEditable()) return;
                 m_isDrawing = true;
                 m_currentShape = createShape(m_currentTool, m_lastPoint);
             } else {
@@ -173,7 +300,7 @@ void CanvasWidget::mousePressEvent(QMouseEvent *event)
             if (polygon && polygon->boundingRect().width() > 10) {
                 polygon->finishShape();
                 pushUndoState();
-                m_shapes.append(m_currentShape);
+                addShape(m_currentShape);
                 emit shapeListChanged();
                 updateModification(true);
                 m_currentShape = nullptr;
@@ -187,34 +314,78 @@ void CanvasWidget::mousePressEvent(QMouseEvent *event)
 
 void CanvasWidget::mouseMoveEvent(QMouseEvent *event)
 {
-    QPoint currentPos = event->pos() / m_scaleFactor;
+    if (m_isPanning) {
+        m_viewport.panBy(event->position() - m_panOrigin);
+        m_panOrigin = event->position();
+        m_viewportAdjusted = true;
+        update();
+        return;
+    }
+
+    QPoint currentPos = toWorld(event->position());
+    const bool wasSnapped = m_hasSnapHit;
+    m_hasSnapHit = false;
 
     if (m_isDrawing && m_currentShape) {
+        if (snapsWhileDrawing()) currentPos = snapPoint(currentPos);
         m_currentShape->update(currentPos);
         m_selectedShape = m_currentShape;
+        m_selection = {m_currentShape};
+        m_selectionBoundsDirty = true;
         emit updateShapeParameters(m_selectedShape->getColor(), m_selectedShape->getPenWidth(),
          m_selectedShape->getFillColor(), m_selectedShape->isShapeFilled(), m_selectedShape->boundingRect().size(), m_selectedShape->rotation());
         update();
-    } 
+    }
+    else if (m_isErasing && (event->buttons() & Qt::LeftButton)) {
+        eraseAlong(m_lastPoint, currentPos);
+        m_lastPoint = currentPos;
+    }
+    else if (m_currentTool == ToolBar::SelectTool && m_dragMode == MarqueeDrag &&
+             (event->buttons() & Qt::LeftButton))
+    {
+        if (m_lassoBand) {
+            if (m_band.last() != currentPos) m_band << currentPos;
+        } else {
+            m_band = QPolygon(QRect(m_dragOrigin, currentPos).normalized());
+        }
+        update();
+    }
+    else if (m_currentTool == ToolBar::SelectTool && m_dragSprite &&
+             (event->buttons() & Qt::LeftButton))
+    {
+        if (m_dragMode == ResizeDrag) currentPos = snapPoint(currentPos);
+        updateSpriteDrag(currentPos);
+        update();
+    }
     else if (m_currentTool == ToolBar::SelectTool && m_selectedShape &&
              (event->buttons() & Qt::LeftButton))
     {
+        // The first step swaps the shape for a copy that the rest of the
+        // drag edits live, so undo restores the original in one step.
+        if (m_dragMode != NoDrag && !m_dragDetached) {
+            m_dragDetached = true;
+            editSelection([](Shape&) {});
+        }
+
         switch (m_dragMode) {
         case MoveDrag: {
-            QPoint delta = currentPos - m_lastPoint;
-            moveSelectedShape(delta);
+            // Measured from the drag start, so snapping never accumulates.
+            const QPoint offset = snapMove(currentPos - m_dragOrigin);
+            const QPoint delta = m_dragBounds.topLeft() + offset - selectionBounds().topLeft();
+            if (!delta.isNull()) moveSelectedShape(delta);
             m_lastPoint = currentPos;
             break;
         }
 
         case ResizeDrag: {
+            currentPos = snapPoint(currentPos, {m_selectedShape.get()});
             QRect rect = m_selectedShape->boundingRect();
             QPoint topLeft = rect.topLeft();
             QPoint delta = currentPos - topLeft;
             QSize newSize(delta.x(), delta.y());
             newSize.setWidth(qMax(10, newSize.width()));
             newSize.setHeight(qMax(10, newSize.height()));
-            resizeSelectedShape(newSize);
+            modifyShape(m_selectedShape, [&newSize](Shape& s) { s.resize(newSize); });
             emit updateShapeParameters(m_selectedShape->getColor(), m_selectedShape->getPenWidth(),
             m_selectedShape->getFillColor(), m_selectedShape->isShapeFilled(), m_selectedShape->boundingRect().size(), m_selectedShape->rotation());
             break;
@@ -229,7 +400,7 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent *event)
             qreal angleRad = std::atan2(vecCurrent.y(), vecCurrent.x()) - std::atan2(center.y(), center.x());
             qreal angleDeg = angleRad * 180.0 / M_PI;
 
-            rotateSelectedShape(angleDeg);
+            modifyShape(m_selectedShape, [angleDeg](Shape& s) { s.rotate(angleDeg); });
             emit updateShapeParameters(m_selectedShape->getColor(), m_selectedShape->getPenWidth(),
             m_selectedShape->getFillColor(), m_selectedShape->isShapeFilled(), m_selectedShape->boundingRect().size(), m_selectedShape->rotation());
 
@@ -243,14 +414,24 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent *event)
 
         update();
     }
+
+    if (wasSnapped && !m_hasSnapHit) update();
 }
 
 
 void CanvasWidget::mouseReleaseEvent(QMouseEvent *event)
 {
+    if (event->button() == Qt::MiddleButton && m_isPanning) {
+        m_isPanning = false;
+        unsetCursor();
+        return;
+    }
+
     if (event->button() == Qt::LeftButton) {
+        m_hasSnapHit = false;
         if (m_isDrawing && m_currentShape) {
-            QPoint currentPos = event->pos() / m_scaleFactor;
+            QPoint currentPos = toWorld(event->position());
+            if (snapsWhileDrawing()) currentPos = snapPoint(currentPos);
             m_currentShape->update(currentPos);
 
             if (m_currentTool == ToolBar::PolygonTool){
@@ -259,8 +440,12 @@ void CanvasWidget::mouseReleaseEvent(QMouseEvent *event)
 
             if (m_currentShape->boundingRect().width() > 5 || 
                 m_currentShape->boundingRect().height() > 5) {
+                // Finished strokes keep a few curve segments, not every sample.
+                if (auto stroke = dynamic_cast<const FreehandShape*>(m_currentShape.get())) {
+                    if (auto curve = fitCurve(stroke->points(), *stroke)) m_currentShape = curve;
+                }
                 pushUndoState();
-                m_shapes.append(m_currentShape);
+                addShape(m_currentShape);
                 emit shapeListChanged();
                 updateModification(true);
             }
@@ -270,24 +455,90 @@ void CanvasWidget::mouseReleaseEvent(QMouseEvent *event)
             update();
         }
 
+        if (m_isErasing) {
+            m_isErasing = false;
+            // The list is rebuilt once per drag, not per step.
+            if (m_eraseChanged) {
+                emit shapeListChanged();
+                updateModification(true);
+            }
+        }
+
+        if (m_dragMode == MarqueeDrag) {
+            selectInBand(event->modifiers() & Qt::ShiftModifier);
+        }
+        endSpriteDrag();
         m_dragMode = NoDrag;
     }
 }
 
 void CanvasWidget::resizeEvent(QResizeEvent *event)
 {
-    QSize newSize = event->size();
-    qreal scaleX = static_cast<qreal>(newSize.width()) / m_originalSize.width();
-    qreal scaleY = static_cast<qreal>(newSize.height()) / m_originalSize.height();
-    m_scaleFactor = qMin(scaleX, scaleY);
+    // Keep fitting the page to the window until the user zooms or pans.
+    if (!m_viewportAdjusted) {
+        m_viewport.fit(QRectF(QPointF(0, 0), m_originalSize), event->size());
+    }
+    update();
+}
+
+void CanvasWidget::wheelEvent(QWheelEvent *event)
+{
+    if (event->modifiers() & Qt::ControlModifier) {
+        // 120 units per notch, ~20% zoom per notch.
+        zoomBy(event->position(), std::pow(1.0015, event->angleDelta().y()));
+    } else {
+        QPointF delta = event->pixelDelta().isNull() ? QPointF(event->angleDelta()) / 2.0
+                                                     : QPointF(event->pixelDelta());
+        if (event->modifiers() & Qt::ShiftModifier) {
+            delta = QPointF(delta.y(), delta.x());
+        }
+        m_viewport.panBy(delta);
+        m_viewportAdjusted = true;
+        update();
+    }
+    event->accept();
+}
+
+bool CanvasWidget::event(QEvent *event)
+{
+    if (event->type() == QEvent::NativeGesture) {
+        auto gesture = static_cast<QNativeGestureEvent*>(event);
+        if (gesture->gestureType() == Qt::ZoomNativeGesture) {
+            zoomBy(gesture->position(), 1.0 + gesture->value());
+            return true;
+        }
+        if (gesture->gestureType() == Qt::PanNativeGesture) {
+            m_viewport.panBy(gesture->delta());
+            m_viewportAdjusted = true;
+            update();
+            return true;
+        }
+    }
+    return QWidget::event(event);
+}
+
+void CanvasWidget::zoomIn()
+{
+    zoomBy(rect().center(), 1.25);
+}
+
+void CanvasWidget::zoomOut()
+{
+    zoomBy(rect().center(), 1.0 / 1.25);
+}
+
+void CanvasWidget::zoomToFit()
+{
+    m_viewportAdjusted = false;
+    m_viewport.fit(QRectF(QPointF(0, 0), m_originalSize), size());
     update();
 }
 
 void CanvasWidget::undo()
 {
     if (!m_undoStack.isEmpty()) {
-        m_redoStack.push({m_shapes});
-        m_shapes = m_undoStack.pop().shapes;
+        m_redoStack.push(currentState());
+        restoreState(m_undoStack.pop());
         emit shapeListChanged();
         updateModification(true);
         checkUndoRedo();
@@ -298,8 +549,8 @@ void CanvasWidget::undo()
 void CanvasWidget::redo()
 {
     if (!m_redoStack.isEmpty()) {
-        m_undoStack.push({m_shapes});
-        m_shapes = m_redoStack.pop().shapes;
+        m_undoStack.push(currentState());
+        restoreState(m_redoStack.pop());
         emit shapeListChanged();
         updateModification(true);
         checkUndoRedo();
@@ -309,10 +560,15 @@ void CanvasWidget::redo()
 
 void CanvasWidget::clear()
 {
-    if (!m_shapes.isEmpty()) {
+    bool empty = m_layers.size() == 1 && activeLayer().shapes.isEmpty();
+    if (!empty) {
         pushUndoState();
-        m_shapes.clear();
-        m_selectedShape = nullptr;
+        // The old pool goes once the undo history lets go of its shapes.
+        ShapeFactory::resetShapeResource();
+        m_layers = {createLayer(tr("Layer 1"))};
+        m_activeLayer = 0;
+        documentChanged();
+        emit layersChanged();
         emit shapeListChanged();
         updateModification(true);
         update();
@@ -324,18 +580,32 @@ bool CanvasWidget::saveToFile(const QString &fileName) {
     if (!file.open(QIODevice::WriteOnly)) return false;
 
     QJsonObject root;
-    root["version"] = 1;
+    root["version"] = 4;
     root["penColor"] = m_penColor.name();
     root["penWidth"] = m_penWidth;
 
-    QJsonArray shapeArray;
-    for (const auto& shape : m_shapes) {
-        QJsonObject obj = shape->toJson();
-        obj["type"] = shape->name();
-        shapeArray.append(obj);
+    // Styles are stored once in a palette; shapes refer to them by index.
+    StylePalette palette;
+    StylePalette::Scope paletteScope(palette);
+
+    // Shared geometry is stored once; instances refer to it by id.
+    QList<std::shared_ptr<Shape>> allShapes;
+    for (const auto& layer : m_layers) {
+        allShapes.append(layer->shapes);
     }
+    QJsonArray symbolArray;
+    for (const auto& symbol : SymbolDefinition::collect(allShapes)) {
+        symbolArray.append(symbol->toJson());
+    }
+    root["symbols"] = symbolArray;
 
-    root["shapes"] = shapeArray;
+    QJsonArray layerArray;
+    for (const auto& layer : m_layers) {
+        layerArray.append(layer->toJson());
+    }
+    root["layers"] = layerArray;
+    root["activeLayer"] = m_activeLayer;
+    root["styles"] = palette.toJson();
 
     QJsonDocument doc(root);
     file.write(doc.toJson());
@@ -346,16 +616,39 @@ bool CanvasWidget::saveToFile(const QString &fileName) {
 }
 
 bool CanvasWidget::exportAsImage(const QString& filePath) {
-    QImage image(m_originalSize, QImage::Format_ARGB32);
+    // The page grows to take in shapes drawn outside of it.
+    QRect documentRect = QRect(QPoint(0, 0), m_originalSize);
+    for (const auto& layer : m_layers) {
+        if (layer->visible) documentRect |= layer->index.boundingRect();
+    }
+
+    QImage image(documentRect.size(), QImage::Format_ARGB32);
     image.fill(Qt::white);
 
     QPainter painter(&image);
-    painter.scale(m_scaleFactor, m_scaleFactor);
-    if (!m_backgroundImage.isNull()) {
-        painter.drawPixmap(0, 0, m_backgroundImage.scaled(m_originalSize));
+    painter.translate(-documentRect.topLeft());
+    if (m_background) {
+        m_background->draw(painter);
     }
-    for (const auto &shape : m_shapes) {
-        shape->draw(painter);
+    for (const auto& layer : m_layers) {
+        if (!layer->visible) continue;
+
+        // Each layer is flattened on its own so opacity applies to the
+        // layer as a whole, as on screen.
+        QImage layerImage(documentRect.size(), QImage::Format_ARGB32_Premultiplied);
+        layerImage.fill(Qt::transparent);
+        QPainter layerPainter(&layerImage);
+        layerPainter.translate(-documentRect.topLeft());
+        for (const auto &shape : layer->shapes) {
+            Effects::draw(layerPainter, *shape, 1.0);
+        }
+        layerPainter.end();
+
+        painter.save();
+        painter.resetTransform();
+        painter.setOpacity(layer->opacity);
+        painter.drawImage(0, 0, layerImage);
+        painter.restore();
     }
     painter.end();
 
@@ -374,28 +667,45 @@ bool CanvasWidget::loadFromFile(const QString &fileName) {
     if (!doc.isObject()) return false;
 
     QJsonObject root = doc.object();
-    if (!root.contains("shapes")) return false;
+    if (!root.contains("layers") && !root.contains("shapes")) return false;
 
-    m_shapes.clear();
-    QJsonArray shapeArray = root["shapes"].toArray();
-    for (const QJsonValue &val : shapeArray) {
-        QJsonObject obj = val.toObject();
-        QString type = obj["type"].toString();
-        std::shared_ptr<Shape> shape;
+    ShapeFactory::resetShapeResource();
 
-        if (type == "Line") shape = std::make_shared<LineShape>();
-        else if (type == "Circle") shape = std::make_shared<CircleShape>();
-        else if (type == "Rectangle") shape = std::make_shared<RectangleShape>();
-        else if (type == "Freehand") shape = std::make_shared<FreehandShape>();
-        else if (type == "Polygon") shape = std::make_shared<PolygonShape>();
-        else if (type == "RegularPolygon") shape = std::make_shared<RegularPolygonShape>();
+    // Files from before the palette keep their styles inline.
+    StylePalette palette;
+    palette.fromJson(root["styles"].toArray());
+    StylePalette::Scope paletteScope(palette);
 
-        if (shape) {
-            shape->fromJson(obj);
-            m_shapes.append(shape);
+    // Keeps the symbols alive until the instances below have bound to them.
+    QList<std::shared_ptr<SymbolDefinition>> symbols;
+    for (const QJsonValue &val : root["symbols"].toArray()) {
+        if (auto symbol = SymbolDefinition::fromJson(val.toObject())) {
+            symbols.append(symbol);
         }
     }
 
+    // Files from before layers hold a single top-level shape list.
+    QJsonArray layerArray = root["layers"].toArray();
+    if (!root.contains("layers")) {
+        QJsonObject layer;
+        layer["shapes"] = root["shapes"];
+        layerArray.append(layer);
+    }
+
+    QList<std::shared_ptr<Layer>> layers;
+    for (const QJsonValue &val : layerArray) {
+        auto layer = createLayer(tr("Layer %1").arg(layers.size() + 1));
+        layer->fromJson(val.toObject());
+        layers.append(layer);
+    }
+    if (layers.isEmpty()) {
+        layers.append(createLayer(tr("Layer 1")));
+    }
+    m_layers = layers;
+    m_activeLayer = qBound(0, root["activeLayer"].toInt(), int(m_layers.size()) - 1);
+
+    documentChanged();
+    emit layersChanged();
     updateModification(false);
     emit shapeListChanged();
     update();
@@ -403,23 +713,98 @@ bool CanvasWidget::loadFromFile(const QString &fileName) {
 }
 
 bool CanvasWidget::loadBackgroundImage(const QString& filePath) {
-    QPixmap img;
-    if (!img.load(filePath)) return false;
-
-    m_backgroundImage = img;
+    std::shared_ptr<ImagePyramid> image = ImagePyramid::load(filePath);
+    if (!image) return false;
+
+    m_backgroundIndex.clear();
+    m_background = ShapeFactory::make<ImageShape>(image, QRect(QPoint(0, 0), m_originalSize));
+    m_backgroundIndex.insert(m_background);
+    m_backgroundTiles.invalidateAll();
+    prunePaths();
     update();
     return true;
 }
 
+bool CanvasWidget::insertImage(const QString& filePath) {
+    if (!activeLayer().isEditable()) return false;
+    std::shared_ptr<ImagePyramid> image = ImagePyramid::load(filePath);
+    if (!image) return false;
+
+    // Large images are scaled down to fit the view.
+    const QRectF visible = m_viewport.mapToWorld(QRectF(QPointF(0, 0), size()));
+    QSizeF extent = image->size();
+    if (extent.width() > visible.width() || extent.height() > visible.height()) {
+        extent.scale(visible.size(), Qt::KeepAspectRatio);
+    }
+    QRect rect(QPoint(0, 0), extent.toSize().expandedTo(QSize(1, 1)));
+    rect.moveCenter(visible.center().toPoint());
+
+    auto shape = ShapeFactory::make<ImageShape>(image, rect);
+    pushUndoState();
+    addShape(shape);
+    setSelection({shape});
+    emit shapeListChanged();
+    updateModification(true);
+    return true;
+}
+
+void CanvasWidget::imageLoaded(const ImagePyramid* pyramid)
+{
+    imageRegionLoaded(pyramid, QRectF());
+}
+
+void CanvasWidget::imageRegionLoaded(const ImagePyramid* pyramid, const QRectF& area)
+{
+    // An empty area stands for the whole image.
+    auto dirty = [&area](const ImageShape* image, const QRect& bounds) {
+        return area.isEmpty() ? bounds : image->mapFromImage(area);
+    };
+
+    if (m_background && m_background->image() == pyramid) {
+        m_backgroundTiles.invalidate(dirty(m_background.get(), m_backgroundIndex.bounds(m_background.get())));
+    }
+    for (const auto& layer : m_layers) {
+        for (const auto& shape : layer->shapes) {
+            auto image = dynamic_cast<const ImageShape*>(shape.get());
+            if (image && image->image() == pyramid) {
+                layer->tiles.invalidate(dirty(image, layer->index.bounds(image)));
+            }
+        }
+    }
+    update();
+}
+
 
 // Private methods implementation
 void CanvasWidget::pushUndoState()
 {
-    m_undoStack.push({m_shapes});
+    m_undoStack.push(currentState());
     m_redoStack.clear();
     checkUndoRedo();
 }
 
+CanvasWidget::CanvasState CanvasWidget::currentState() const
+{
+    CanvasState state;
+    state.layers = m_layers;
+    for (const auto& layer : m_layers) {
+        state.shapes.append(layer->shapes);
+    }
+    state.activeLayer = m_activeLayer;
+    return state;
+}
+
+void CanvasWidget::restoreState(const CanvasState& state)
+{
+    m_layers = state.layers;
+    for (qsizetype i = 0; i < m_layers.size(); ++i) {
+        m_layers[i]->shapes = state.shapes[i];
+    }
+    m_activeLayer = state.activeLayer;
+    documentChanged();
+    emit layersChanged();
+}
+
 void CanvasWidget::updateModification(bool modified)
 {
     m_modified = modified;
@@ -434,138 +819,181 @@ void CanvasWidget::checkUndoRedo()
 
 std::shared_ptr<Shape> CanvasWidget::createShape(ToolBar::Tool tool, const QPoint &startPoint)
 {
-    std::shared_ptr<Shape> shape;
-    
-    switch (tool) {
-    case ToolBar::LineTool:
-        shape = std::make_shared<LineShape>(startPoint, startPoint);
-        break;
-    case ToolBar::CircleTool:
-        shape = std::make_shared<CircleShape>(startPoint, startPoint);
-        break;
-    case ToolBar::RectangleTool:
-        shape = std::make_shared<RectangleShape>(startPoint, startPoint);
-        break;
-    case ToolBar::FreehandTool:
-        shape = std::make_shared<FreehandShape>();
-        shape->update(startPoint);
-        break;
-    case ToolBar::PolygonTool:
-        shape = std::make_shared<PolygonShape>();
-        shape->update(startPoint);
-        break;
-    case ToolBar::RegularPolygonTool:
-        shape = std::make_shared<RegularPolygonShape>(startPoint, 10, 5);
-        break;
-    default:
-        return nullptr;
-    }
-    
+    std::shared_ptr<Shape> shape = ShapeFactory::begin(tool, startPoint);
+    if (!shape) return nullptr;
+
     shape->setColor(m_penColor);
     shape->setPenWidth(m_penWidth);
     return shape;
 }
 
-void CanvasWidget::selectShapeAt(const QPoint &pos) {
-    m_selectedShape = nullptr;
-    
-    for (auto it = m_shapes.rbegin(); it != m_shapes.rend(); ++it) {
-        if ((*it)->contains(pos)) {
-            m_selectedShape = *it;
-            emit shapeSelected(m_selectedShape->name());
-            
-            emit updateShapeParameters(m_selectedShape->getColor(), m_selectedShape->getPenWidth(),
-            m_selectedShape->getFillColor(), m_selectedShape->isShapeFilled(), m_selectedShape->boundingRect().size(), m_selectedShape->rotation());
-            break;
+std::shared_ptr<Shape> CanvasWidget::shapeAt(const QPoint &pos, int32_t* layerIndex) const
+{
+    for (qsizetype i = m_layers.size() - 1; i >= 0; --i) {
+        const Layer& layer = *m_layers[i];
+        if (!layer.isEditable()) continue;
+
+        QList<std::shared_ptr<Shape>> candidates = layer.index.query(pos);
+        // Candidates come in stacking order; the first hit from the top wins.
+        for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+            if ((*it)->contains(pos)) {
+                if (layerIndex) *layerIndex = int32_t(i);
+                return *it;
+            }
         }
     }
-    
+    return nullptr;
+}
+
+void CanvasWidget::setSelection(const QList<std::shared_ptr<Shape>>& shapes)
+{
+    m_selection = shapes;
+    if (m_selection.size() > 1) {
+        activeLayer().index.sortByOrder(m_selection);
+    }
+    m_selectedShape = m_selection.size() == 1 ? m_selection.first() : nullptr;
+    m_selectionBoundsDirty = true;
+
+    if (m_selectedShape) {
+        emit shapeSelected(m_selectedShape->name());
+        emit updateShapeParameters(m_selectedShape->getColor(), m_selectedShape->getPenWidth(),
+        m_selectedShape->getFillColor(), m_selectedShape->isShapeFilled(), m_selectedShape->boundingRect().size(), m_selectedShape->rotation());
+    } else if (!m_selection.isEmpty()) {
+        emit shapeSelected(tr("%1 shapes").arg(m_selection.size()));
+    } else {
+        emit shapeSelected("");
+    }
     update();
 }
 
+void CanvasWidget::selectInBand(bool extend)
+{
+    const QRect area = m_band.boundingRect();
+    QList<std::shared_ptr<Shape>> selection = extend ? m_selection : QList<std::shared_ptr<Shape>>();
+    if (!activeLayer().isEditable()) {
+        m_band.clear();
+        setSelection(selection);
+        return;
+    }
+    QSet<const Shape*> selected;
+    for (const auto& shape : selection) {
+        selected.insert(shape.get());
+    }
+
+    // Only shapes whose bounds lie entirely inside the band are picked.
+    for (const auto& shape : activeLayer().index.query(area)) {
+        if (selected.contains(shape.get())) continue;
+
+        QRect rect = shape->boundingRect();
+        bool inside = area.contains(rect);
+        if (inside && m_lassoBand) {
+            inside = m_band.containsPoint(rect.topLeft(), Qt::OddEvenFill)
+                  && m_band.containsPoint(rect.topRight(), Qt::OddEvenFill)
+                  && m_band.containsPoint(rect.bottomLeft(), Qt::OddEvenFill)
+                  && m_band.containsPoint(rect.bottomRight(), Qt::OddEvenFill);
+        }
+        if (inside) selection.append(shape);
+    }
+
+    m_band.clear();
+    setSelection(selection);
+}
+
+QRect CanvasWidget::selectionBounds() const
+{
+    if (m_selectionBoundsDirty) {
+        m_selectionBounds = QRect();
+        for (const auto& shape : m_selection) {
+            if (activeLayer().index.contains(shape.get())) {
+                m_selectionBounds |= shape->boundingRect();
+            }
+        }
+        m_selectionBoundsDirty = false;
+    }
+    return m_selectionBounds;
+}
+
 void CanvasWidget::moveSelectedShape(const QPoint &delta)
 {
     if (m_selectedShape) {
-        m_selectedShape->moveBy(delta.x(), delta.y());
-        updateModification(true);
-        update();
+        modifyShape(m_selectedShape, [&delta](Shape& s) { s.moveBy(delta.x(), delta.y()); });
     }
 }
 
 void CanvasWidget::rotateSelectedShape(double angle) {
     if (m_selectedShape) {
-        m_selectedShape->rotate(angle);
-        updateModification(true);
-        update();
+        editSelection([angle](Shape& s) { s.rotate(angle); });
     }
 }
 
 void CanvasWidget::resizeSelectedShape(const QSize& newSize) {
     if (m_selectedShape) {
-        m_selectedShape->resize(newSize);
-        updateModification(true);
-        update();
+        editSelection([&newSize](Shape& s) { s.resize(newSize); });
     }
 }
 
 void CanvasWidget::resizePolygonSides(int32_t sides){
-    auto polygon = dynamic_cast<RegularPolygonShape*>(m_selectedShape.get());
-    if (m_selectedShape && polygon != nullptr) {
-        polygon->setSides(sides);
-        updateModification(true);
-        update();
+    if (dynamic_cast<RegularPolygonShape*>(m_selectedShape.get())) {
+        editSelection([sides](Shape& s) { static_cast<RegularPolygonShape&>(s).setSides(sides); });
     }
 }
 
 void CanvasWidget::deleteSelectedShape() {
-    if (m_selectedShape) {
-        auto it = std::find(m_shapes.begin(), m_shapes.end(), m_selectedShape);
-        if (it != m_shapes.end()) {
-            pushUndoState();
-            m_shapes.erase(it);
-            m_selectedShape = nullptr;
-            updateModification(true);
-            update();
-            emit shapeListChanged();
-        }
+    Layer& layer = activeLayer();
+    if (m_selection.isEmpty()) return;
+
+    QSet<const Shape*> doomed;
+    QRect dirty;
+    for (const auto& shape : m_selection) {
+        doomed.insert(shape.get());
+        dirty |= layer.index.bounds(shape.get());
     }
+
+    pushUndoState();
+    m_dragSprite.reset();
+    layer.shapes.removeIf([&doomed](const std::shared_ptr<Shape>& shape) { return doomed.contains(shape.get()); });
+    for (const Shape* shape : doomed) {
+        layer.index.remove(shape);
+    }
+    layer.tiles.invalidate(dirty);
+    setSelection({});
+    updateModification(true);
+    update();
+    emit shapeListChanged();
 }
 
 QList<QString> CanvasWidget::getShapeList() const {
     QList<QString> list;
     int32_t index = 0;
-    for (const auto& shape : m_shapes) {
+    for (const auto& shape : activeLayer().shapes) {
         list.append(shape->name() + " " + QString::number(index++));
     }
     return list;
 }
 
 void CanvasWidget::selectShapeFromList(size_t index) {
-    if (index >= 0 && index < m_shapes.size()) {
-        m_selectedShape = m_shapes[index];
-        emit shapeSelected(m_selectedShape->name());
-
-        emit updateShapeParameters(m_selectedShape->getColor(), m_selectedShape->getPenWidth(),
-        m_selectedShape->getFillColor(), m_selectedShape->isShapeFilled(), m_selectedShape->boundingRect().size(), m_selectedShape->rotation());
-
-        update();
+    if (index >= 0 && index < activeLayer().shapes.size()) {
+        setSelection({activeLayer().shapes[index]});
     }
 }
 
 void CanvasWidget::stopAllAnimations() {
-    for (const auto& shape : m_shapes) {
+    for (const auto& shape : activeLayer().shapes) {
         shape->setAnimated(false);
     }
     update();
 }
 
 void CanvasWidget::moveShapeUp() {
+    Layer& layer = activeLayer();
     if (!m_selectedShape) return;
     
-    auto it = std::find(m_shapes.begin(), m_shapes.end(), m_selectedShape);
-    if (it != m_shapes.end() && it + 1 != m_shapes.end()) {
+    auto it = std::find(layer.shapes.begin(), layer.shapes.end(), m_selectedShape);
+    if (it != layer.shapes.end() && it + 1 != layer.shapes.end()) {
         pushUndoState();
+        layer.tiles.invalidate(layer.index.bounds(it->get()) | layer.index.bounds((it + 1)->get()));
         std::iter_swap(it, it + 1);
+        layer.index.rebuild(layer.shapes);
         updateModification(true);
         emit shapeListChanged();
         update();
@@ -573,31 +1001,844 @@ void CanvasWidget::moveShapeUp() {
 }
 
 void CanvasWidget::moveShapeDown() {
+    Layer& layer = activeLayer();
     if (!m_selectedShape) return;
     
-    auto it = std::find(m_shapes.begin(), m_shapes.end(), m_selectedShape);
-    if (it != m_shapes.end() && it != m_shapes.begin()) {
+    auto it = std::find(layer.shapes.begin(), layer.shapes.end(), m_selectedShape);
+    if (it != layer.shapes.end() && it != layer.shapes.begin()) {
         pushUndoState();
+        layer.tiles.invalidate(layer.index.bounds(it->get()) | layer.index.bounds((it - 1)->get()));
         std::iter_swap(it, it - 1);
+        layer.index.rebuild(layer.shapes);
         updateModification(true);
         emit shapeListChanged();
         update();
     }
 }
 
-void CanvasWidget::setFillColor(const QColor& color, bool enabled) {
-    if (!m_selectedShape) return;
+void CanvasWidget::groupSelection() {
+    Layer& layer = activeLayer();
+    QList<std::shared_ptr<Shape>> members;
+    for (const auto& shape : m_selection) {
+        if (layer.index.contains(shape.get())) members.append(shape);
+    }
+    if (members.size() < 2) return;
+
+    pushUndoState();
+    // The group takes the stacking position of its topmost member.
+    auto group = ShapeFactory::make<GroupShape>(members);
+    QSet<const Shape*> grouped;
+    for (const auto& shape : members) {
+        grouped.insert(shape.get());
+    }
+
+    QList<std::shared_ptr<Shape>> shapes;
+    shapes.reserve(layer.shapes.size() - members.size() + 1);
+    for (const auto& shape : layer.shapes) {
+        if (shape == members.last()) shapes.append(group);
+        else if (!grouped.contains(shape.get())) shapes.append(shape);
+    }
+    layer.shapes = shapes;
 
-    m_selectedShape->setFillColor(color);
-    m_selectedShape->setFilled(enabled);
+    documentChanged();
+    setSelection({group});
     updateModification(true);
-    update();
+    emit shapeListChanged();
 }
 
-void CanvasWidget::scaleShapes()
-{
-    if (qFuzzyCompare(m_scaleFactor, 1.0)) {
-        return;
+void CanvasWidget::ungroupSelection() {
+    Layer& layer = activeLayer();
+    QHash<const Shape*, QList<std::shared_ptr<Shape>>> expanded;
+    for (const auto& shape : m_selection) {
+        if (auto group = dynamic_cast<const GroupShape*>(shape.get())) {
+            expanded.insert(shape.get(), group->bakedChildren());
+        }
     }
-    update();
-}
\ No newline at end of file
+    if (expanded.isEmpty()) return;
+
+    pushUndoState();
+    QList<std::shared_ptr<Shape>> shapes;
+    QList<std::shared_ptr<Shape>> selection;
+    for (const auto& shape : layer.shapes) {
+        auto it = expanded.constFind(shape.get());
+        if (it == expanded.constEnd()) {
+            shapes.append(shape);
+        } else {
+            shapes.append(*it);
+            selection.append(*it);
+        }
+    }
+    layer.shapes = shapes;
+
+    documentChanged();
+    setSelection(selection);
+    updateModification(true);
+    emit shapeListChanged();
+}
+
+void CanvasWidget::convertToSymbol() {
+    Layer& layer = activeLayer();
+    QList<std::shared_ptr<Shape>> members;
+    for (const auto& shape : m_selection) {
+        if (layer.index.contains(shape.get())) members.append(shape);
+    }
+    if (members.isEmpty()) return;
+
+    // The symbol owns copies, so undo can still bring back the originals.
+    std::shared_ptr<Shape> geometry;
+    if (members.size() == 1) {
+        geometry = ShapeFactory::clone(*members.first());
+    } else {
+        QList<std::shared_ptr<Shape>> copies;
+        for (const auto& shape : members) {
+            if (auto copy = ShapeFactory::clone(*shape)) copies.append(copy);
+        }
+        geometry = ShapeFactory::make<GroupShape>(copies);
+    }
+    auto symbol = SymbolDefinition::create(geometry);
+    if (!symbol) return;
+
+    pushUndoState();
+    auto instance = ShapeFactory::make<InstanceShape>(symbol);
+    QSet<const Shape*> replaced;
+    for (const auto& shape : members) {
+        replaced.insert(shape.get());
+    }
+
+    QList<std::shared_ptr<Shape>> shapes;
+    for (const auto& shape : layer.shapes) {
+        if (shape == members.last()) shapes.append(instance);
+        else if (!replaced.contains(shape.get())) shapes.append(shape);
+    }
+    layer.shapes = shapes;
+
+    documentChanged();
+    setSelection({instance});
+    updateModification(true);
+    emit shapeListChanged();
+}
+
+void CanvasWidget::cloneSelection() {
+    QList<std::shared_ptr<Shape>> clones;
+    for (const auto& shape : m_selection) {
+        auto instance = dynamic_cast<const InstanceShape*>(shape.get());
+        if (!instance || !activeLayer().index.contains(shape.get())) continue;
+
+        std::shared_ptr<Shape> clone = ShapeFactory::clone(*instance);
+        if (!clone) continue;
+        clone->moveBy(CloneOffset, CloneOffset);
+        clones.append(clone);
+    }
+    if (clones.isEmpty()) return;
+
+    pushUndoState();
+    for (const auto& clone : clones) {
+        addShape(clone);
+    }
+    setSelection(clones);
+    updateModification(true);
+    emit shapeListChanged();
+}
+
+void CanvasWidget::unionSelection() {
+    combineSelection(PolygonClip::Union);
+}
+
+void CanvasWidget::intersectSelection() {
+    combineSelection(PolygonClip::Intersection);
+}
+
+void CanvasWidget::subtractSelection() {
+    combineSelection(PolygonClip::Difference);
+}
+
+void CanvasWidget::combineSelection(PolygonClip::Operation operation) {
+    Layer& layer = activeLayer();
+    QSet<const Shape*> selected;
+    for (const auto& shape : m_selection) {
+        selected.insert(shape.get());
+    }
+
+    QList<std::shared_ptr<Shape>> operands;
+    for (const auto& shape : layer.shapes) {
+        if (!selected.contains(shape.get())) continue;
+        const Shape* s = shape.get();
+        if (dynamic_cast<const PolygonShape*>(s) || dynamic_cast<const RectangleShape*>(s)
+            || dynamic_cast<const CircleShape*>(s) || dynamic_cast<const RegularPolygonShape*>(s)) {
+            operands.append(shape);
+        }
+    }
+    if (operands.size() < 2) return;
+
+    QList<QPolygonF> outline = PolygonClip::flatten(operands.first()->snapPath());
+    for (qsizetype i = 1; i < operands.size(); ++i) {
+        outline = PolygonClip::apply(outline, PolygonClip::flatten(operands[i]->snapPath()), operation);
+    }
+
+    // Each separate piece becomes its own polygon, its holes kept as
+    // separate rings so no bridge edge gets stroked.
+    QList<std::shared_ptr<Shape>> results;
+    for (QList<QPolygon> piece : PolygonClip::pieces(outline)) {
+        piece = FloodFill::simplify(piece, 0.5);
+        if (piece.isEmpty()) continue;
+        const QPolygon outer = piece.takeFirst();
+        auto result = ShapeFactory::make<PolygonShape>(outer, piece);
+        result->setStyle(operands.first()->style());
+        results.append(result);
+    }
+
+    pushUndoState();
+    QSet<const Shape*> consumed;
+    for (const auto& shape : operands) {
+        consumed.insert(shape.get());
+    }
+
+    // The result takes the stacking position of the lowest operand.
+    QList<std::shared_ptr<Shape>> shapes;
+    for (const auto& shape : layer.shapes) {
+        if (shape == operands.first()) shapes.append(results);
+        else if (!consumed.contains(shape.get())) shapes.append(shape);
+    }
+    layer.shapes = shapes;
+
+    documentChanged();
+    setSelection(results);
+    updateModification(true);
+    emit shapeListChanged();
+}
+
+void CanvasWidget::setFillColor(const QColor& color, bool enabled) {
+    m_fillColor = color;
+    editSelection([&color, enabled](Shape& s) {
+        s.setFillColor(color);
+        s.setFilled(enabled);
+    });
+}
+
+void CanvasWidget::setFillGradient(ShapeStyle::Gradient kind, const QColor& end, qreal angle) {
+    editSelection([kind, &end, angle](Shape& s) {
+        // Filling first lets instances take over their symbol's style.
+        if (kind != ShapeStyle::NoGradient) s.setFilled(true);
+        s.setStyle(s.style().withGradient(kind, end, angle));
+    });
+}
+
+void CanvasWidget::setBlur(qreal radius) {
+    editSelection([radius](Shape& s) { s.setStyle(s.style().withBlur(radius)); });
+}
+
+void CanvasWidget::setDropShadow(const QColor& color, const QPointF& offset, qreal radius) {
+    editSelection([&color, &offset, radius](Shape& s) {
+        s.setStyle(s.style().withShadow(color, offset, radius));
+    });
+}
+
+void CanvasWidget::editSelection(const std::function<void(Shape&)>& edit) {
+    Layer& layer = activeLayer();
+    QList<std::shared_ptr<Shape>> originals;
+    for (const auto& shape : m_selection) {
+        if (layer.index.contains(shape.get())) originals.append(shape);
+    }
+    if (originals.isEmpty()) return;
+
+    // Edited copies replace the shapes, so undo brings the originals back.
+    pushUndoState();
+    QRect dirty;
+    QList<std::shared_ptr<Shape>> edited;
+    for (const auto& shape : originals) {
+        std::shared_ptr<Shape> copy = ShapeFactory::clone(*shape);
+        if (!copy) continue;
+        edit(*copy);
+        copy->markChanged();
+
+        dirty |= layer.index.bounds(shape.get());
+        layer.shapes.replace(layer.shapes.indexOf(shape), copy);
+        layer.index.replace(shape.get(), {copy});
+        dirty |= layer.index.bounds(copy.get());
+        edited.append(copy);
+    }
+    layer.tiles.invalidate(dirty);
+    update();
+
+    setSelection(edited);
+    updateModification(true);
+    emit shapeListChanged();
+}
+
+void CanvasWidget::scaleShapes()
+{
+    if (qFuzzyCompare(m_viewport.zoom(), 1.0)) {
+        return;
+    }
+    update();
+}
+
+QPoint CanvasWidget::toWorld(const QPointF& devicePos) const
+{
+    return m_viewport.mapToWorld(devicePos).toPoint();
+}
+
+void CanvasWidget::zoomBy(const QPointF& devicePos, qreal factor)
+{
+    m_viewport.zoomAt(devicePos, factor);
+    m_viewportAdjusted = true;
+    update();
+}
+
+void CanvasWidget::addShape(const std::shared_ptr<Shape>& shape)
+{
+    Layer& layer = activeLayer();
+    layer.shapes.append(shape);
+    layer.index.insert(shape);
+    layer.tiles.invalidate(layer.index.bounds(shape.get()));
+    update();
+}
+
+void CanvasWidget::modifyShape(const std::shared_ptr<Shape>& shape, const std::function<void(Shape&)>& edit)
+{
+    modifyShapes({shape}, edit);
+}
+
+void CanvasWidget::modifyShapes(const QList<std::shared_ptr<Shape>>& shapes, const std::function<void(Shape&)>& edit)
+{
+    modifyShapes(activeLayer(), shapes, edit);
+}
+
+void CanvasWidget::modifyShapes(Layer& layer, const QList<std::shared_ptr<Shape>>& shapes, const std::function<void(Shape&)>& edit)
+{
+    QRect dirty;
+    for (const auto& shape : shapes) {
+        dirty |= layer.index.bounds(shape.get());
+    }
+    {
+        QWriteLocker locker(&m_documentLock);
+        for (const auto& shape : shapes) {
+            edit(*shape);
+            shape->markChanged();
+        }
+    }
+
+    for (const auto& shape : shapes) {
+        if (!layer.index.contains(shape.get())) continue;
+        layer.index.update(shape.get());
+        dirty |= layer.index.bounds(shape.get());
+    }
+    layer.tiles.invalidate(dirty);
+    m_selectionBoundsDirty = true;
+    update();
+}
+
+void CanvasWidget::eraseAlong(const QPoint& from, const QPoint& to)
+{
+    Layer& layer = activeLayer();
+    const qreal radius = EraserRadius / m_viewport.zoom();
+    const QLineF sweep(from, to);
+    const int32_t reach = qCeil(radius);
+    const QRect area = QRect(from, to).normalized().adjusted(-reach, -reach, reach, reach);
+
+    // The grid narrows the strokes down, their chunk bounds the segments.
+    QHash<const Shape*, QList<std::shared_ptr<Shape>>> replacements;
+    for (const auto& shape : layer.index.query(area)) {
+        QList<QVector<QPoint>> runs;
+        QList<std::shared_ptr<Shape>> pieces;
+        if (auto stroke = dynamic_cast<const FreehandShape*>(shape.get())) {
+            if (!stroke->erase(sweep, radius, runs)) continue;
+            for (const QVector<QPoint>& run : runs) {
+                auto piece = ShapeFactory::make<FreehandShape>(run);
+                piece->setStyle(stroke->style());
+                piece->setAnimated(stroke->isAnimated());
+                pieces.append(piece);
+            }
+        } else if (auto curve = dynamic_cast<const CurveShape*>(shape.get())) {
+            // Curves are cut as a polyline and the pieces fitted again.
+            FreehandShape outline(curve->flatten(CurveTolerance / (2 * m_viewport.zoom())));
+            outline.setStyle(curve->style());
+            if (!outline.erase(sweep, radius, runs)) continue;
+            for (const QVector<QPoint>& run : runs) {
+                if (auto piece = fitCurve(run, *curve)) pieces.append(piece);
+            }
+        } else {
+            continue;
+        }
+        replacements.insert(shape.get(), pieces);
+    }
+    if (replacements.isEmpty()) return;
+
+    if (!m_eraseChanged) {
+        pushUndoState();
+        m_eraseChanged = true;
+    }
+
+    QRect dirty;
+    QList<std::shared_ptr<Shape>> shapes;
+    shapes.reserve(layer.shapes.size());
+    for (const auto& shape : layer.shapes) {
+        auto it = replacements.constFind(shape.get());
+        if (it == replacements.constEnd()) {
+            shapes.append(shape);
+            continue;
+        }
+        dirty |= layer.index.bounds(shape.get());
+        layer.index.replace(shape.get(), *it);
+        shapes.append(*it);
+    }
+    layer.shapes = shapes;
+    layer.tiles.invalidate(dirty);
+    update();
+}
+
+void CanvasWidget::setSnapTargets(int32_t targets)
+{
+    m_snap.setTargets(targets);
+    update();
+}
+
+bool CanvasWidget::snapsWhileDrawing() const
+{
+    switch (m_currentTool) {
+    case ToolBar::LineTool:
+    case ToolBar::CircleTool:
+    case ToolBar::RectangleTool:
+    case ToolBar::PolygonTool:
+    case ToolBar::RegularPolygonTool:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QList<const SpatialIndex*> CanvasWidget::snapIndexes() const
+{
+    QList<const SpatialIndex*> indexes;
+    for (const auto& layer : m_layers) {
+        if (layer->visible) indexes.append(&layer->index);
+    }
+    return indexes;
+}
+
+QPoint CanvasWidget::snapPoint(const QPoint& pos, const QSet<const Shape*>& exclude)
+{
+    m_hasSnapHit = false;
+    if (!m_snap.targets()) return pos;
+
+    SnapEngine::Hit hit;
+    if (!m_snap.snap(pos, SnapRadius / m_viewport.zoom(), snapIndexes(), exclude, hit)) return pos;
+    m_snapHit = hit;
+    m_hasSnapHit = true;
+    return hit.pos.toPoint();
+}
+
+QPoint CanvasWidget::snapMove(const QPoint& offset)
+{
+    m_hasSnapHit = false;
+    if (!m_snap.targets() || m_dragBounds.isEmpty()) return offset;
+
+    QSet<const Shape*> exclude;
+    for (const auto& shape : m_selection) {
+        exclude.insert(shape.get());
+    }
+    const QList<const SpatialIndex*> indexes = snapIndexes();
+    const qreal radius = SnapRadius / m_viewport.zoom();
+
+    const QRectF moved = QRectF(m_dragBounds).translated(offset);
+    const QPointF probes[] = {moved.topLeft(), moved.topRight(), moved.bottomLeft(),
+                              moved.bottomRight(), moved.center()};
+    qreal best = std::numeric_limits<qreal>::max();
+    QPointF correction;
+    for (const QPointF& probe : probes) {
+        SnapEngine::Hit hit;
+        if (!m_snap.snap(probe, radius, indexes, exclude, hit)) continue;
+
+        const QPointF d = hit.pos - probe;
+        const qreal distance = QPointF::dotProduct(d, d);
+        if (distance < best) {
+            best = distance;
+            correction = d;
+            m_snapHit = hit;
+            m_hasSnapHit = true;
+        }
+    }
+    return offset + correction.toPoint();
+}
+
+std::shared_ptr<Shape> CanvasWidget::fitCurve(const QVector<QPoint>& points, const Shape& source) const
+{
+    const QVector<QPointF> controls = CurveFit::fit(points, CurveTolerance / m_viewport.zoom());
+    if (controls.size() < 4) return nullptr;
+
+    auto curve = ShapeFactory::make<CurveShape>(controls);
+    curve->setStyle(source.style());
+    curve->setAnimated(source.isAnimated());
+    return curve;
+}
+
+void CanvasWidget::editText(const QPoint& pos)
+{
+    // Clicking an existing label edits it in place.
+    std::shared_ptr<TextShape> label;
+    for (const auto& shape : activeLayer().index.query(pos)) {
+        auto text = std::dynamic_pointer_cast<TextShape>(shape);
+        if (text && text->contains(pos)) label = text;
+    }
+
+    bool ok = false;
+    const QString text = QInputDialog::getMultiLineText(this, tr("Text"), tr("Text:"),
+                                                        label ? label->text() : QString(), &ok);
+    if (!ok) return;
+
+    if (label && text.isEmpty()) {
+        setSelection({label});
+        deleteSelectedShape();
+        return;
+    }
+
+    if (label) {
+        // A new shape rather than an edit, so undo brings the old text back.
+        auto edited = std::static_pointer_cast<TextShape>(ShapeFactory::clone(*label));
+        edited->setText(text);
+
+        Layer& layer = activeLayer();
+        const QRect dirty = layer.index.bounds(label.get());
+        pushUndoState();
+        layer.shapes.replace(layer.shapes.indexOf(label), edited);
+        layer.index.replace(label.get(), {edited});
+        layer.tiles.invalidate(dirty | layer.index.bounds(edited.get()));
+        update();
+    } else {
+        if (text.isEmpty()) return;
+        auto shape = ShapeFactory::make<TextShape>(pos, text);
+        shape->setColor(m_penColor);
+        pushUndoState();
+        addShape(shape);
+    }
+    emit shapeListChanged();
+    updateModification(true);
+}
+
+void CanvasWidget::bucketFill(const QPoint& pos)
+{
+    QRectF scene(QPointF(0, 0), m_originalSize);
+    for (const auto& layer : m_layers) {
+        if (layer->visible) scene |= QRectF(layer->index.boundingRect());
+    }
+    if (!scene.contains(pos)) return;
+
+    // Start from what is on screen and only widen the raster, at a
+    // coarser resolution, while the region runs off its edge.
+    QRectF window = m_viewport.mapToWorld(QRectF(QPointF(0, 0), size())) & scene;
+    if (!window.contains(pos)) window = scene;
+
+    FloodFill::Mask mask;
+    qreal scale = 1.0;
+    for (;;) {
+        scale = qMin(m_viewport.zoom(), FloodFill::MaxRasterSize / qMax(window.width(), window.height()));
+        const QImage image = renderScene(window, scale);
+        const QPointF local = (QPointF(pos) - window.topLeft()) * scale;
+        const QPoint seed(qBound(0, qFloor(local.x()), image.width() - 1),
+                          qBound(0, qFloor(local.y()), image.height() - 1));
+        bool reachedBorder = false;
+        mask = FloodFill::fill(image, seed, &reachedBorder);
+        if (!reachedBorder || window == scene) break;
+
+        window = window.adjusted(-window.width() / 2, -window.height() / 2,
+                                 window.width() / 2, window.height() / 2) & scene;
+    }
+
+    QList<QPolygon> rings = FloodFill::simplify(FloodFill::trace(mask), 1.0);
+    if (rings.isEmpty()) return;
+
+    QTransform toWorld;
+    toWorld.translate(window.left(), window.top());
+    toWorld.scale(1.0 / scale, 1.0 / scale);
+    for (QPolygon& ring : rings) {
+        ring = toWorld.map(ring);
+    }
+
+    const QColor color = m_fillColor.isValid() ? m_fillColor : m_penColor;
+    const QPolygon outline = rings.takeFirst();
+    auto region = ShapeFactory::make<PolygonShape>(outline, rings);
+    region->setStyle(region->style().withStroke(Qt::transparent).withWidth(0).withFill(color).withFilled(true));
+
+    pushUndoState();
+    addShape(region);
+    emit shapeListChanged();
+    updateModification(true);
+}
+
+QImage CanvasWidget::renderScene(const QRectF& worldRect, qreal scale) const
+{
+    QImage image(qMax(1, qCeil(worldRect.width() * scale)), qMax(1, qCeil(worldRect.height() * scale)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.scale(scale, scale);
+    painter.translate(-worldRect.topLeft());
+    for (const auto& layer : m_layers) {
+        if (!layer->visible) continue;
+        for (const auto& shape : layer->index.query(worldRect.toAlignedRect())) {
+            Effects::draw(painter, *shape, scale);
+        }
+    }
+    return image;
+}
+
+void CanvasWidget::documentChanged()
+{
+    // The rebuilt index has no hidden shapes, so an unfinished drag is dropped.
+    m_dragSprite.reset();
+    for (const auto& layer : m_layers) {
+        layer->rebuild();
+    }
+    prunePaths();
+    m_selection.removeIf([this](const std::shared_ptr<Shape>& shape) {
+        return !activeLayer().index.contains(shape.get());
+    });
+    m_selectedShape = m_selection.size() == 1 ? m_selection.first() : nullptr;
+    m_selectionBoundsDirty = true;
+    update();
+}
+
+std::shared_ptr<Layer> CanvasWidget::createLayer(const QString& name)
+{
+    auto layer = std::make_shared<Layer>(name, m_renderer);
+    connect(&layer->tiles, &TileCache::tilesReady, this, QOverload<>::of(&QWidget::update));
+    return layer;
+}
+
+void CanvasWidget::prunePaths()
+{
+    m_renderer.prunePaths([this](const Shape* shape) {
+        if (m_backgroundIndex.contains(shape)) return true;
+        for (const auto& layer : m_layers) {
+            if (layer->index.contains(shape)) return true;
+        }
+        return false;
+    });
+}
+
+QList<QString> CanvasWidget::getLayerList() const {
+    QList<QString> list;
+    for (const auto& layer : m_layers) {
+        list.append(layer->name);
+    }
+    return list;
+}
+
+bool CanvasWidget::isLayerVisible(int32_t index) const {
+    return index >= 0 && index < m_layers.size() && m_layers[index]->visible;
+}
+
+bool CanvasWidget::isLayerLocked(int32_t index) const {
+    return index >= 0 && index < m_layers.size() && m_layers[index]->locked;
+}
+
+qreal CanvasWidget::layerOpacity(int32_t index) const {
+    return index >= 0 && index < m_layers.size() ? m_layers[index]->opacity : 1.0;
+}
+
+void CanvasWidget::addLayer() {
+    pushUndoState();
+    // New layers go directly above the current one.
+    m_layers.insert(m_activeLayer + 1, createLayer(tr("Layer %1").arg(m_layers.size() + 1)));
+    setActiveLayer(m_activeLayer + 1);
+    updateModification(true);
+    emit layersChanged();
+}
+
+void CanvasWidget::removeLayer() {
+    if (m_layers.size() < 2) return;
+
+    pushUndoState();
+    m_dragSprite.reset();
+    m_layers.removeAt(m_activeLayer);
+    m_activeLayer = qMin(m_activeLayer, int32_t(m_layers.size()) - 1);
+    setSelection({});
+    updateModification(true);
+    emit layersChanged();
+    emit shapeListChanged();
+    update();
+}
+
+void CanvasWidget::raiseLayer() {
+    if (m_activeLayer + 1 >= m_layers.size()) return;
+
+    pushUndoState();
+    m_layers.swapItemsAt(m_activeLayer, m_activeLayer + 1);
+    ++m_activeLayer;
+    updateModification(true);
+    emit layersChanged();
+    update();
+}
+
+void CanvasWidget::lowerLayer() {
+    if (m_activeLayer == 0) return;
+
+    pushUndoState();
+    m_layers.swapItemsAt(m_activeLayer, m_activeLayer - 1);
+    --m_activeLayer;
+    updateModification(true);
+    emit layersChanged();
+    update();
+}
+
+void CanvasWidget::setActiveLayer(int32_t index) {
+    if (index < 0 || index >= m_layers.size() || index == m_activeLayer) return;
+
+    endSpriteDrag();
+    setSelection({});
+    m_activeLayer = index;
+    emit layersChanged();
+    emit shapeListChanged();
+}
+
+void CanvasWidget::setLayerVisible(int32_t index, bool visible) {
+    if (index < 0 || index >= m_layers.size() || m_layers[index]->visible == visible) return;
+
+    m_layers[index]->visible = visible;
+    if (index == m_activeLayer && !visible) setSelection({});
+    updateModification(true);
+    emit layersChanged();
+    update();
+}
+
+void CanvasWidget::setLayerLocked(int32_t index, bool locked) {
+    if (index < 0 || index >= m_layers.size() || m_layers[index]->locked == locked) return;
+
+    m_layers[index]->locked = locked;
+    if (index == m_activeLayer && locked) setSelection({});
+    updateModification(true);
+    emit layersChanged();
+    update();
+}
+
+void CanvasWidget::setLayerOpacity(int32_t index, qreal opacity) {
+    if (index < 0 || index >= m_layers.size()) return;
+
+    // Opacity is applied when compositing, so no tiles are re-rendered.
+    m_layers[index]->opacity = qBound(0.0, opacity, 1.0);
+    updateModification(true);
+    update();
+}
+
+void CanvasWidget::beginSpriteDrag()
+{
+    Layer& layer = activeLayer();
+    if (m_selection.size() == 1) {
+        // Single shapes are cheap to edit live unless they are complex.
+        if (m_dragMode != MoveDrag || m_selectedShape->isAnimated() ||
+            m_selectedShape->complexity() < SpriteComplexity) {
+            return;
+        }
+    }
+
+    QRect bounds;
+    for (const auto& shape : m_selection) {
+        bounds |= layer.index.bounds(shape.get());
+    }
+    if (bounds.isEmpty()) return;
+
+    m_dragSprite = std::make_unique<ShapeSprite>(m_selection, bounds, m_viewport.zoom());
+    for (const auto& shape : m_selection) {
+        layer.index.setHidden(shape.get(), true);
+    }
+    layer.tiles.invalidate(bounds);
+    update();
+}
+
+void CanvasWidget::updateSpriteDrag(const QPoint& pos)
+{
+    QTransform transform;
+    switch (m_dragMode) {
+    case MoveDrag: {
+        QPoint delta = snapMove(pos - m_dragOrigin);
+        transform.translate(delta.x(), delta.y());
+        break;
+    }
+
+    case ResizeDrag: {
+        QPointF origin = m_dragBounds.topLeft();
+        qreal sx = qMax(10, pos.x() - m_dragBounds.left()) / qreal(qMax(1, m_dragBounds.width()));
+        qreal sy = qMax(10, pos.y() - m_dragBounds.top()) / qreal(qMax(1, m_dragBounds.height()));
+        transform.translate(origin.x(), origin.y());
+        transform.scale(sx, sy);
+        transform.translate(-origin.x(), -origin.y());
+        break;
+    }
+
+    case RotateDrag: {
+        QPointF center = QRectF(m_dragBounds).center();
+        QPointF from = m_dragOrigin - center;
+        QPointF to = pos - center;
+        qreal angle = qRadiansToDegrees(std::atan2(to.y(), to.x()) - std::atan2(from.y(), from.x()));
+        transform.translate(center.x(), center.y());
+        transform.rotate(angle);
+        transform.translate(-center.x(), -center.y());
+        break;
+    }
+
+    default:
+        return;
+    }
+
+    m_dragSprite->setTransform(transform);
+    updateModification(true);
+}
+
+void CanvasWidget::endSpriteDrag()
+{
+    Layer& layer = activeLayer();
+    if (!m_dragSprite) return;
+
+    const QTransform transform = m_dragSprite->transform();
+    m_dragSprite.reset();
+
+    QRect bounds;
+    for (const auto& shape : m_selection) {
+        layer.index.setHidden(shape.get(), false);
+        bounds |= layer.index.bounds(shape.get());
+    }
+    layer.tiles.invalidate(bounds);
+
+    if (transform.isIdentity()) {
+        update();
+        return;
+    }
+
+    // The whole drag is committed as one undo step that swaps every shape
+    // for a transformed copy.
+    switch (m_dragMode) {
+    case MoveDrag: {
+        QPoint delta(qRound(transform.dx()), qRound(transform.dy()));
+        editSelection([delta](Shape& s) { s.moveBy(delta.x(), delta.y()); });
+        break;
+    }
+
+    case ResizeDrag: {
+        const qreal sx = transform.m11();
+        const qreal sy = transform.m22();
+        editSelection([&transform, sx, sy](Shape& s) {
+            QRect rect = s.boundingRect();
+            QPoint center = transform.map(QPointF(rect.center())).toPoint();
+            s.resize(QSize(qMax(1, qRound(rect.width() * sx)), qMax(1, qRound(rect.height() * sy))));
+            QPoint delta = center - s.boundingRect().center();
+            s.moveBy(delta.x(), delta.y());
+        });
+        break;
+    }
+
+    case RotateDrag: {
+        const qreal angle = qRadiansToDegrees(std::atan2(transform.m12(), transform.m11()));
+        editSelection([&transform, angle](Shape& s) {
+            QPoint center = s.boundingRect().center();
+            QPoint delta = transform.map(QPointF(center)).toPoint() - center;
+            s.moveBy(delta.x(), delta.y());
+            s.rotate(s.rotation() + angle);
+        });
+        break;
+    }
+
+    default:
+        break;
+    }
+}
@@ -0,0 +1,46 @@
+#include "../include/Layer.h"
+#include "../include/Shapes/ShapeFactory.h"
+#include <QJsonArray>
+
+Layer::Layer(const QString& name, TileRenderer& renderer)
+    : name(name), tiles(index, renderer)
+{
+    tiles.setClearColor(Qt::transparent);
+}
+
+void Layer::rebuild() {
+    index.rebuild(shapes);
+    tiles.invalidateAll();
+}
+
+QJsonObject Layer::toJson() const {
+    QJsonArray shapeArray;
+    for (const auto& shape : shapes) {
+        shapeArray.append(ShapeFactory::toJson(*shape));
+    }
+
+    QJsonObject obj;
+    obj["name"] = name;
+    obj["visible"] = visible;
+    obj["locked"] = locked;
+    obj["opacity"] = opacity;
+    obj["shapes"] = shapeArray;
+    return obj;
+}
+
+void Layer::fromJson(const QJsonObject& obj) {
+    name = obj["name"].toString(name);
+    visible = obj["visible"].toBool(true);
+    locked = obj["locked"].toBool(false);
+    opacity = obj["opacity"].toDouble(1.0);
+
+    shapes.clear();
+    const QJsonArray shapeArray = obj["shapes"].toArray();
+    shapes.reserve(shapeArray.size());
+    for (const QJsonValue& value : shapeArray) {
+        if (std::shared_ptr<Shape> shape = ShapeFactory::fromJson(value.toObject())) {
+            shapes.append(shape);
+        }
+    }
+    rebuild();
+}
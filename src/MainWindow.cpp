@@ -9,6 +9,9 @@
 #include <QVBoxLayout>
 #include <QStyleFactory>
 #include <QDockWidget>
+#include <QSignalBlocker>
+#include <QInputDialog>
+#include <QColorDialog>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -134,6 +137,35 @@ void MainWindow::createControls() {
     m_shapeListWidget->setAlternatingRowColors(true);
     panelLayout->addWidget(m_shapeListWidget);
 
+    // Пласты, ніжні першы
+    QLabel *layersLabel = new QLabel(tr("Layers:"));
+    panelLayout->addWidget(layersLabel);
+
+    m_layerListWidget = new QListWidget();
+    panelLayout->addWidget(m_layerListWidget);
+
+    QHBoxLayout *layerButtonsLayout = new QHBoxLayout();
+    m_addLayerButton = new QPushButton(tr("New"));
+    m_removeLayerButton = new QPushButton(tr("Delete"));
+    m_raiseLayerButton = new QPushButton(tr("Raise"));
+    m_lowerLayerButton = new QPushButton(tr("Lower"));
+    layerButtonsLayout->addWidget(m_addLayerButton);
+    layerButtonsLayout->addWidget(m_removeLayerButton);
+    layerButtonsLayout->addWidget(m_raiseLayerButton);
+    layerButtonsLayout->addWidget(m_lowerLayerButton);
+    panelLayout->addLayout(layerButtonsLayout);
+
+    QHBoxLayout *layerPropsLayout = new QHBoxLayout();
+    m_lockLayerCheck = new QCheckBox(tr("Locked"));
+    m_layerOpacitySlider = new QSlider(Qt::Horizontal);
+    m_layerOpacitySlider->setRange(0, 100);
+    layerPropsLayout->addWidget(m_lockLayerCheck);
+    layerPropsLayout->addWidget(new QLabel(tr("Opacity:")));
+    layerPropsLayout->addWidget(m_layerOpacitySlider);
+    panelLayout->addLayout(layerPropsLayout);
+
+    updateLayerList();
+
     // Дадаем панель у правую частку акна
     QDockWidget *dock = new QDockWidget(tr("Properties"), this);
     dock->setWidget(controlPanel);
@@ -193,6 +225,24 @@ void MainWindow::setupConnections() {
             this, &MainWindow::updateShapeList);
     connect(m_shapeListWidget, &QListWidget::currentRowChanged, 
             m_canvas, &CanvasWidget::selectShapeFromList);
+
+    // Злучэнні пластоў
+    connect(m_canvas, &CanvasWidget::layersChanged,
+            this, &MainWindow::updateLayerList);
+    connect(m_layerListWidget, &QListWidget::currentRowChanged,
+            m_canvas, &CanvasWidget::setActiveLayer);
+    connect(m_layerListWidget, &QListWidget::itemChanged,
+            this, [this](QListWidgetItem *item) {
+                m_canvas->setLayerVisible(m_layerListWidget->row(item), item->checkState() == Qt::Checked);
+            });
+    connect(m_addLayerButton, &QPushButton::clicked, m_canvas, &CanvasWidget::addLayer);
+    connect(m_removeLayerButton, &QPushButton::clicked, m_canvas, &CanvasWidget::removeLayer);
+    connect(m_raiseLayerButton, &QPushButton::clicked, m_canvas, &CanvasWidget::raiseLayer);
+    connect(m_lowerLayerButton, &QPushButton::clicked, m_canvas, &CanvasWidget::lowerLayer);
+    connect(m_lockLayerCheck, &QCheckBox::toggled,
+            this, [this](bool locked) { m_canvas->setLayerLocked(m_canvas->activeLayerIndex(), locked); });
+    connect(m_layerOpacitySlider, &QSlider::valueChanged,
+            this, [this](int value) { m_canvas->setLayerOpacity(m_canvas->activeLayerIndex(), value / 100.0); });
 }
 
 
@@ -281,6 +331,71 @@ void MainWindow::importBackground() {
     }
 }
 
+void MainWindow::insertImage() {
+    QString fileName = QFileDialog::getOpenFileName(this,
+        tr("Insert Image"), "", tr("Image Files (*.png *.jpg *.jpeg *.bmp)"));
+    if (!fileName.isEmpty()) {
+        if (m_canvas->insertImage(fileName)) {
+            statusBar()->showMessage(tr("Image inserted"), 2000);
+        } else {
+            statusBar()->showMessage(tr("Failed to insert image"), 2000);
+        }
+    }
+}
+
+void MainWindow::updateSnapping()
+{
+    int32_t targets = 0;
+    if (m_snapGridAct->isChecked()) targets |= SnapEngine::Grid;
+    if (m_snapObjectsAct->isChecked()) targets |= SnapEngine::Objects;
+    m_canvas->setSnapTargets(targets);
+}
+
+void MainWindow::editGradient()
+{
+    const QStringList kinds = {tr("None"), tr("Linear"), tr("Radial")};
+    bool ok = false;
+    const QString kind = QInputDialog::getItem(this, tr("Gradient Fill"), tr("Gradient:"), kinds, 1, false, &ok);
+    if (!ok) return;
+    if (kind == kinds[0]) {
+        m_canvas->setFillGradient(ShapeStyle::NoGradient, QColor(), 0.0);
+        return;
+    }
+
+    // The gradient starts from the fill colour already set.
+    const QColor end = QColorDialog::getColor(Qt::white, this, tr("Gradient End Color"),
+                                              QColorDialog::ShowAlphaChannel);
+    if (!end.isValid()) return;
+
+    if (kind == kinds[2]) {
+        m_canvas->setFillGradient(ShapeStyle::RadialGradient, end, 0.0);
+        return;
+    }
+    const double angle = QInputDialog::getDouble(this, tr("Gradient Fill"), tr("Angle (degrees):"),
+                                                 90.0, -360.0, 360.0, 0, &ok);
+    if (ok) m_canvas->setFillGradient(ShapeStyle::LinearGradient, end, angle);
+}
+
+void MainWindow::editBlur()
+{
+    bool ok = false;
+    const double radius = QInputDialog::getDouble(this, tr("Blur"), tr("Radius (0 for none):"),
+                                                  4.0, 0.0, 100.0, 1, &ok);
+    if (ok) m_canvas->setBlur(radius);
+}
+
+void MainWindow::editShadow()
+{
+    const QColor color = QColorDialog::getColor(QColor(0, 0, 0, 128), this, tr("Shadow Color"),
+                                                QColorDialog::ShowAlphaChannel);
+    if (!color.isValid()) return;
+
+    bool ok = false;
+    const double radius = QInputDialog::getDouble(this, tr("Drop Shadow"), tr("Blur radius:"),
+                                                  3.0, 0.0, 100.0, 1, &ok);
+    // The shadow falls down and to the right, a little further than it spreads.
+    if (ok) m_canvas->setDropShadow(color, QPointF(radius + 2, radius + 2), radius);
+}
 
 void MainWindow::about()
 {
@@ -294,6 +409,28 @@ void MainWindow::updateShapeList() {
     m_shapeListWidget->addItems(m_canvas->getShapeList());
 }
 
+void MainWindow::updateLayerList() {
+    QSignalBlocker blocker(m_layerListWidget);
+    m_layerListWidget->clear();
+
+    const QList<QString> names = m_canvas->getLayerList();
+    for (int32_t i = 0; i < names.size(); ++i) {
+        QListWidgetItem *item = new QListWidgetItem(names[i], m_layerListWidget);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(m_canvas->isLayerVisible(i) ? Qt::Checked : Qt::Unchecked);
+    }
+    m_layerListWidget->setCurrentRow(m_canvas->activeLayerIndex());
+    updateLayerControls();
+}
+
+void MainWindow::updateLayerControls() {
+    const int32_t index = m_canvas->activeLayerIndex();
+    QSignalBlocker lockBlocker(m_lockLayerCheck);
+    QSignalBlocker opacityBlocker(m_layerOpacitySlider);
+    m_lockLayerCheck->setChecked(m_canvas->isLayerLocked(index));
+    m_layerOpacitySlider->setValue(qRound(m_canvas->layerOpacity(index) * 100));
+}
+
 void MainWindow::createActions()
 {
     // File actions
@@ -319,6 +456,9 @@ void MainWindow::createActions()
     m_importBackgroundAct = new QAction(tr("Import Background"), this);
     connect(m_importBackgroundAct, &QAction::triggered, this, &MainWindow::importBackground);
 
+    m_insertImageAct = new QAction(tr("Insert Image..."), this);
+    connect(m_insertImageAct, &QAction::triggered, this, &MainWindow::insertImage);
+
     m_exitAct = new QAction(tr("E&xit"), this);
     m_exitAct->setShortcut(QKeySequence::Quit);
     connect(m_exitAct, &QAction::triggered, this, &QWidget::close);
@@ -337,6 +477,66 @@ void MainWindow::createActions()
     m_clearAct = new QAction(tr("&Clear"), this);
     connect(m_clearAct, &QAction::triggered, m_canvas, &CanvasWidget::clear);
 
+    m_groupAct = new QAction(tr("&Group"), this);
+    m_groupAct->setShortcut(tr("Ctrl+G"));
+    connect(m_groupAct, &QAction::triggered, m_canvas, &CanvasWidget::groupSelection);
+
+    m_ungroupAct = new QAction(tr("U&ngroup"), this);
+    m_ungroupAct->setShortcut(tr("Ctrl+Shift+G"));
+    connect(m_ungroupAct, &QAction::triggered, m_canvas, &CanvasWidget::ungroupSelection);
+
+    m_symbolAct = new QAction(tr("Convert to &Symbol"), this);
+    m_symbolAct->setShortcut(tr("Ctrl+K"));
+    connect(m_symbolAct, &QAction::triggered, m_canvas, &CanvasWidget::convertToSymbol);
+
+    m_cloneAct = new QAction(tr("Clo&ne"), this);
+    m_cloneAct->setShortcut(tr("Alt+D"));
+    connect(m_cloneAct, &QAction::triggered, m_canvas, &CanvasWidget::cloneSelection);
+
+    m_unionAct = new QAction(tr("Union"), this);
+    m_unionAct->setShortcut(tr("Ctrl+Alt+U"));
+    connect(m_unionAct, &QAction::triggered, m_canvas, &CanvasWidget::unionSelection);
+
+    m_intersectAct = new QAction(tr("Intersection"), this);
+    m_intersectAct->setShortcut(tr("Ctrl+Alt+I"));
+    connect(m_intersectAct, &QAction::triggered, m_canvas, &CanvasWidget::intersectSelection);
+
+    m_subtractAct = new QAction(tr("Difference"), this);
+    m_subtractAct->setShortcut(tr("Ctrl+Alt+D"));
+    connect(m_subtractAct, &QAction::triggered, m_canvas, &CanvasWidget::subtractSelection);
+
+    m_gradientAct = new QAction(tr("Gradient &Fill..."), this);
+    connect(m_gradientAct, &QAction::triggered, this, &MainWindow::editGradient);
+
+    m_blurAct = new QAction(tr("&Blur..."), this);
+    connect(m_blurAct, &QAction::triggered, this, &MainWindow::editBlur);
+
+    m_shadowAct = new QAction(tr("Drop S&hadow..."), this);
+    connect(m_shadowAct, &QAction::triggered, this, &MainWindow::editShadow);
+
+    // View actions
+    m_zoomInAct = new QAction(tr("Zoom &In"), this);
+    m_zoomInAct->setShortcut(QKeySequence::ZoomIn);
+    connect(m_zoomInAct, &QAction::triggered, m_canvas, &CanvasWidget::zoomIn);
+
+    m_zoomOutAct = new QAction(tr("Zoom &Out"), this);
+    m_zoomOutAct->setShortcut(QKeySequence::ZoomOut);
+    connect(m_zoomOutAct, &QAction::triggered, m_canvas, &CanvasWidget::zoomOut);
+
+    m_zoomFitAct = new QAction(tr("&Fit to Window"), this);
+    m_zoomFitAct->setShortcut(tr("Ctrl+0"));
+    connect(m_zoomFitAct, &QAction::triggered, m_canvas, &CanvasWidget::zoomToFit);
+
+    m_snapGridAct = new QAction(tr("Snap to &Grid"), this);
+    m_snapGridAct->setCheckable(true);
+    m_snapGridAct->setChecked(m_canvas->snapTargets() & SnapEngine::Grid);
+    connect(m_snapGridAct, &QAction::toggled, this, &MainWindow::updateSnapping);
+
+    m_snapObjectsAct = new QAction(tr("Snap to &Objects"), this);
+    m_snapObjectsAct->setCheckable(true);
+    m_snapObjectsAct->setChecked(m_canvas->snapTargets() & SnapEngine::Objects);
+    connect(m_snapObjectsAct, &QAction::toggled, this, &MainWindow::updateSnapping);
+
     // Help actions
     m_aboutAct = new QAction(tr("&About"), this);
     connect(m_aboutAct, &QAction::triggered, this, &MainWindow::about);
@@ -351,6 +551,7 @@ void MainWindow::createMenus()
     m_fileMenu->addAction(m_saveAsAct);
     m_fileMenu->addAction(m_exportImageAct);
     m_fileMenu->addAction(m_importBackgroundAct);
+    m_fileMenu->addAction(m_insertImageAct);
     m_fileMenu->addSeparator();
     m_fileMenu->addAction(m_exitAct);
 
@@ -358,8 +559,29 @@ void MainWindow::createMenus()
     m_editMenu->addAction(m_undoAct);
     m_editMenu->addAction(m_redoAct);
     m_editMenu->addSeparator();
+    m_editMenu->addAction(m_groupAct);
+    m_editMenu->addAction(m_ungroupAct);
+    m_editMenu->addAction(m_symbolAct);
+    m_editMenu->addAction(m_cloneAct);
+    m_editMenu->addSeparator();
+    m_editMenu->addAction(m_unionAct);
+    m_editMenu->addAction(m_intersectAct);
+    m_editMenu->addAction(m_subtractAct);
+    m_editMenu->addSeparator();
+    m_editMenu->addAction(m_gradientAct);
+    m_editMenu->addAction(m_blurAct);
+    m_editMenu->addAction(m_shadowAct);
+    m_editMenu->addSeparator();
     m_editMenu->addAction(m_clearAct);
 
+    m_viewMenu = menuBar()->addMenu(tr("&View"));
+    m_viewMenu->addAction(m_zoomInAct);
+    m_viewMenu->addAction(m_zoomOutAct);
+    m_viewMenu->addAction(m_zoomFitAct);
+    m_viewMenu->addSeparator();
+    m_viewMenu->addAction(m_snapGridAct);
+    m_viewMenu->addAction(m_snapObjectsAct);
+
     m_helpMenu = menuBar()->addMenu(tr("&Help"));
     m_helpMenu->addAction(m_aboutAct);
 }
@@ -0,0 +1,183 @@
+#include "../../include/Rendering/CurveFit.h"
+#include <QtMath>
+#include <array>
+#include <cmath>
+
+namespace CurveFit {
+
+namespace {
+
+using Bezier = std::array<QPointF, 4>;
+
+qreal lengthOf(const QPointF& v) {
+    return std::hypot(v.x(), v.y());
+}
+
+QPointF normalized(const QPointF& v) {
+    const qreal length = lengthOf(v);
+    return length > 0.0 ? v / length : v;
+}
+
+qreal squaredDistance(const QPointF& a, const QPointF& b) {
+    const QPointF d = a - b;
+    return QPointF::dotProduct(d, d);
+}
+
+// Normalized chord length along the samples from first to last.
+QVector<qreal> chordParameters(const QVector<QPointF>& d, qsizetype first, qsizetype last) {
+    QVector<qreal> u(last - first + 1);
+    u[0] = 0.0;
+    for (qsizetype i = first + 1; i <= last; ++i) {
+        u[i - first] = u[i - first - 1] + lengthOf(d[i] - d[i - 1]);
+    }
+    const qreal total = u.last();
+    for (qreal& value : u) value /= total;
+    return u;
+}
+
+// Least-squares control points for fixed end tangents.
+Bezier generate(const QVector<QPointF>& d, qsizetype first, qsizetype last, const QVector<qreal>& u,
+                const QPointF& tHat1, const QPointF& tHat2) {
+    const QPointF p0 = d[first];
+    const QPointF p3 = d[last];
+
+    qreal c00 = 0.0, c01 = 0.0, c11 = 0.0, x0 = 0.0, x1 = 0.0;
+    for (qsizetype i = 0; i < u.size(); ++i) {
+        const qreal t = u[i];
+        const qreal s = 1.0 - t;
+        const qreal b0 = s * s * s, b1 = 3 * t * s * s, b2 = 3 * t * t * s, b3 = t * t * t;
+        const QPointF a0 = tHat1 * b1;
+        const QPointF a1 = tHat2 * b2;
+
+        c00 += QPointF::dotProduct(a0, a0);
+        c01 += QPointF::dotProduct(a0, a1);
+        c11 += QPointF::dotProduct(a1, a1);
+
+        const QPointF rest = d[first + i] - (p0 * (b0 + b1) + p3 * (b2 + b3));
+        x0 += QPointF::dotProduct(a0, rest);
+        x1 += QPointF::dotProduct(a1, rest);
+    }
+
+    const qreal det = c00 * c11 - c01 * c01;
+    qreal alpha1 = det != 0.0 ? (x0 * c11 - x1 * c01) / det : 0.0;
+    qreal alpha2 = det != 0.0 ? (c00 * x1 - c01 * x0) / det : 0.0;
+
+    // Degenerate or flipped solutions fall back to the Wu/Barsky guess.
+    const qreal chord = lengthOf(p3 - p0);
+    const qreal epsilon = 1.0e-6 * chord;
+    if (alpha1 < epsilon || alpha2 < epsilon) {
+        alpha1 = alpha2 = chord / 3.0;
+    }
+    return {p0, p0 + tHat1 * alpha1, p3 + tHat2 * alpha2, p3};
+}
+
+// Largest squared distance of an inner sample, and where it is.
+qreal maxError(const QVector<QPointF>& d, qsizetype first, qsizetype last, const Bezier& bezier,
+               const QVector<qreal>& u, qsizetype& split) {
+    qreal worst = 0.0;
+    split = (first + last + 1) / 2;
+    for (qsizetype i = first + 1; i < last; ++i) {
+        const qreal error = squaredDistance(pointAt(bezier.data(), u[i - first]), d[i]);
+        if (error >= worst) {
+            worst = error;
+            split = i;
+        }
+    }
+    return worst;
+}
+
+// One Newton-Raphson step towards the parameter closest to point.
+qreal newtonRoot(const Bezier& q, const QPointF& point, qreal u) {
+    const std::array<QPointF, 3> q1 = {(q[1] - q[0]) * 3, (q[2] - q[1]) * 3, (q[3] - q[2]) * 3};
+    const std::array<QPointF, 2> q2 = {(q1[1] - q1[0]) * 2, (q1[2] - q1[1]) * 2};
+
+    const qreal s = 1.0 - u;
+    const QPointF qu = pointAt(q.data(), u);
+    const QPointF q1u = q1[0] * (s * s) + q1[1] * (2 * s * u) + q1[2] * (u * u);
+    const QPointF q2u = q2[0] * s + q2[1] * u;
+
+    const qreal numerator = QPointF::dotProduct(qu - point, q1u);
+    const qreal denominator = QPointF::dotProduct(q1u, q1u) + QPointF::dotProduct(qu - point, q2u);
+    return denominator != 0.0 ? u - numerator / denominator : u;
+}
+
+void append(QVector<QPointF>& out, const Bezier& bezier) {
+    out.append(bezier[1]);
+    out.append(bezier[2]);
+    out.append(bezier[3]);
+}
+
+void fitCubic(const QVector<QPointF>& d, qsizetype first, qsizetype last,
+              const QPointF& tHat1, const QPointF& tHat2, qreal error2, QVector<QPointF>& out) {
+    if (last - first == 1) {
+        const qreal third = lengthOf(d[last] - d[first]) / 3.0;
+        append(out, {d[first], d[first] + tHat1 * third, d[last] + tHat2 * third, d[last]});
+        return;
+    }
+
+    QVector<qreal> u = chordParameters(d, first, last);
+    Bezier bezier = generate(d, first, last, u, tHat1, tHat2);
+    qsizetype split = 0;
+    qreal error = maxError(d, first, last, bezier, u, split);
+    if (error < error2) {
+        append(out, bezier);
+        return;
+    }
+
+    // Close misses are worth reparameterizing before splitting.
+    if (error < error2 * 4) {
+        for (int32_t i = 0; i < MaxIterations; ++i) {
+            for (qsizetype k = 0; k < u.size(); ++k) {
+                u[k] = newtonRoot(bezier, d[first + k], u[k]);
+            }
+            bezier = generate(d, first, last, u, tHat1, tHat2);
+            error = maxError(d, first, last, bezier, u, split);
+            if (error < error2) {
+                append(out, bezier);
+                return;
+            }
+        }
+    }
+
+    QPointF tHatCenter = normalized(d[split - 1] - d[split + 1]);
+    if (tHatCenter.isNull()) {
+        // The stroke doubles back on itself here.
+        tHatCenter = normalized(d[split - 1] - d[split]);
+    }
+    fitCubic(d, first, split, tHat1, tHatCenter, error2, out);
+    fitCubic(d, split, last, -tHatCenter, tHat2, error2, out);
+}
+
+}
+
+QVector<QPointF> fit(const QVector<QPoint>& points, qreal error) {
+    QVector<QPointF> d;
+    d.reserve(points.size());
+    for (const QPoint& point : points) {
+        if (d.isEmpty() || d.last() != QPointF(point)) d.append(point);
+    }
+    if (d.size() < 2) return {};
+
+    QVector<QPointF> out;
+    out.append(d.first());
+    const qsizetype last = d.size() - 1;
+    fitCubic(d, 0, last, normalized(d[1] - d[0]), normalized(d[last - 1] - d[last]), error * error, out);
+    return out;
+}
+
+QPointF pointAt(const QPointF* segment, qreal t) {
+    const qreal s = 1.0 - t;
+    return segment[0] * (s * s * s) + segment[1] * (3 * s * s * t)
+         + segment[2] * (3 * s * t * t) + segment[3] * (t * t * t);
+}
+
+int32_t flattenSteps(const QPointF* segment, qreal tolerance) {
+    // n uniform pieces stray at most M / (8 n^2), with M the largest
+    // second derivative, 6 times the larger second difference.
+    const qreal bend = qMax(lengthOf(segment[0] - segment[1] * 2 + segment[2]),
+                            lengthOf(segment[1] - segment[2] * 2 + segment[3]));
+    if (tolerance <= 0.0) return 1;
+    return qMax(1, qCeil(std::sqrt(6.0 * bend / (8.0 * tolerance))));
+}
+
+}
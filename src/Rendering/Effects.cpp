@@ -0,0 +1,245 @@
+#include "../../include/Rendering/Effects.h"
+#include "../../include/Rendering/LodPolicy.h"
+#include <QtMath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EFFECTS_SSE2
+#endif
+
+namespace {
+
+// A pixel's four channels widened to 32-bit lanes, so running box sums
+// over a whole row or column cannot overflow.
+#ifdef EFFECTS_SSE2
+using Lanes = __m128i;
+
+inline Lanes zeroLanes() { return _mm_setzero_si128(); }
+
+inline Lanes load(quint32 pixel) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_cvtsi32_si128(int32_t(pixel));
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero);
+}
+
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_epi32(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_epi32(a, b); }
+
+// Rounds sum * scale and packs the lanes back into a pixel.
+inline quint32 store(Lanes sum, __m128 scale) {
+    const __m128i mean = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), scale));
+    const __m128i words = _mm_packs_epi32(mean, mean);
+    return quint32(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+}
+
+using Scale = __m128;
+inline Scale makeScale(int32_t width) { return _mm_set1_ps(1.0f / width); }
+#else
+struct Lanes {
+    int32_t v[4];
+};
+
+inline Lanes zeroLanes() { return Lanes{{0, 0, 0, 0}}; }
+
+inline Lanes load(quint32 pixel) {
+    return Lanes{{int32_t(pixel & 0xff), int32_t((pixel >> 8) & 0xff),
+                  int32_t((pixel >> 16) & 0xff), int32_t(pixel >> 24)}};
+}
+
+inline Lanes add(Lanes a, Lanes b) {
+    for (int32_t i = 0; i < 4; ++i) a.v[i] += b.v[i];
+    return a;
+}
+
+inline Lanes sub(Lanes a, Lanes b) {
+    for (int32_t i = 0; i < 4; ++i) a.v[i] -= b.v[i];
+    return a;
+}
+
+inline quint32 store(Lanes sum, float scale) {
+    quint32 pixel = 0;
+    for (int32_t i = 0; i < 4; ++i) {
+        pixel |= quint32(qBound(0, qRound(sum.v[i] * scale), 255)) << (8 * i);
+    }
+    return pixel;
+}
+
+using Scale = float;
+inline Scale makeScale(int32_t width) { return 1.0f / width; }
+#endif
+
+// Box widths whose three passes best match a Gaussian of deviation sigma.
+void boxesForGauss(qreal sigma, int32_t radii[3]) {
+    const int32_t n = 3;
+    int32_t lower = qFloor(std::sqrt(12.0 * sigma * sigma / n + 1.0));
+    if (lower % 2 == 0) --lower;
+    const int32_t upper = lower + 2;
+    const int32_t m = qRound((12.0 * sigma * sigma - n * lower * lower - 4.0 * n * lower - 3.0 * n) / (-4.0 * lower - 4.0));
+    for (int32_t i = 0; i < n; ++i) {
+        radii[i] = ((i < m ? lower : upper) - 1) / 2;
+    }
+}
+
+// One box pass along a row of count pixels.
+void boxRow(const quint32* in, quint32* out, int32_t count, int32_t radius) {
+    const Scale scale = makeScale(2 * radius + 1);
+    Lanes sum = zeroLanes();
+    for (int32_t i = 0; i < qMin(radius, count); ++i) {
+        sum = add(sum, load(in[i]));
+    }
+    for (int32_t x = 0; x < count; ++x) {
+        if (x + radius < count) sum = add(sum, load(in[x + radius]));
+        out[x] = store(sum, scale);
+        if (x - radius >= 0) sum = sub(sum, load(in[x - radius]));
+    }
+}
+
+// One box pass down every column at once, a row at a time, so memory is
+// walked in order.
+void boxColumns(const QImage& in, QImage& out, int32_t radius) {
+    const int32_t width = in.width();
+    const int32_t height = in.height();
+    const Scale scale = makeScale(2 * radius + 1);
+    auto row = [&in](int32_t y) { return reinterpret_cast<const quint32*>(in.constScanLine(y)); };
+
+    std::vector<Lanes> sums(width, zeroLanes());
+    for (int32_t y = 0; y < qMin(radius, height); ++y) {
+        const quint32* line = row(y);
+        for (int32_t x = 0; x < width; ++x) sums[x] = add(sums[x], load(line[x]));
+    }
+    for (int32_t y = 0; y < height; ++y) {
+        if (y + radius < height) {
+            const quint32* entering = row(y + radius);
+            for (int32_t x = 0; x < width; ++x) sums[x] = add(sums[x], load(entering[x]));
+        }
+        quint32* target = reinterpret_cast<quint32*>(out.scanLine(y));
+        for (int32_t x = 0; x < width; ++x) target[x] = store(sums[x], scale);
+        if (y - radius >= 0) {
+            const quint32* leaving = row(y - radius);
+            for (int32_t x = 0; x < width; ++x) sums[x] = sub(sums[x], load(leaving[x]));
+        }
+    }
+}
+
+QImage renderShape(const Shape& shape, const QRect& bounds, qreal scale) {
+    QImage image(qMax(1, qCeil(bounds.width() * scale)), qMax(1, qCeil(bounds.height() * scale)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.scale(scale, scale);
+    painter.translate(-bounds.topLeft());
+    shape.drawLod(painter, scale);
+    painter.end();
+    return image;
+}
+
+}
+
+namespace Effects {
+
+void blur(QImage& image, qreal sigma) {
+    if (sigma < 0.5 || image.isNull()) return;
+    Q_ASSERT(image.format() == QImage::Format_ARGB32_Premultiplied);
+
+    int32_t radii[3];
+    boxesForGauss(sigma, radii);
+
+    QImage scratch(image.size(), image.format());
+    for (int32_t radius : radii) {
+        for (int32_t y = 0; y < image.height(); ++y) {
+            boxRow(reinterpret_cast<const quint32*>(image.constScanLine(y)),
+                   reinterpret_cast<quint32*>(scratch.scanLine(y)), image.width(), radius);
+        }
+        boxColumns(scratch, image, radius);
+    }
+}
+
+Result render(const Shape& shape, qreal scale) {
+    const ShapeStyle& style = shape.style();
+    const QRect bounds = shape.renderBounds();
+    const qreal longest = qMax(bounds.width(), bounds.height()) * scale;
+    if (longest > MaxSize) scale *= MaxSize / longest;
+
+    Result result;
+    result.rect = QRectF(bounds);
+    QImage content = renderShape(shape, bounds, scale);
+    if (content.isNull()) return result;
+
+    result.image = QImage(content.size(), content.format());
+    result.image.fill(Qt::transparent);
+    QPainter painter(&result.image);
+
+    if (style.shadow.alpha() > 0) {
+        QImage shadow = content;
+        QPainter tint(&shadow);
+        tint.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        tint.fillRect(shadow.rect(), style.shadow);
+        tint.end();
+        blur(shadow, style.shadowBlur * scale);
+        painter.drawImage(style.shadowOffset * scale, shadow);
+    }
+
+    blur(content, style.blur * scale);
+    painter.drawImage(0, 0, content);
+    painter.end();
+    return result;
+}
+
+void draw(QPainter& painter, const Shape& shape, qreal scale) {
+    if (!shape.style().hasEffects()) {
+        shape.drawLod(painter, scale);
+        return;
+    }
+
+    const Result result = render(shape, scale);
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(result.rect, result.image);
+    painter.restore();
+}
+
+}
+
+Effects::Result EffectCache::result(const Shape& shape, qreal scale) {
+    const int32_t level = Lod::levelForScale(scale);
+    const QPair<const Shape*, int32_t> key(&shape, level);
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end() && it->version == shape.version()) {
+            m_order.splice(m_order.begin(), m_order, it->position);
+            return it->result;
+        }
+    }
+
+    // Rendered at the level's scale so every tile of the level blits it
+    // one to one.
+    Entry entry;
+    entry.version = shape.version();
+    entry.result = Effects::render(shape, std::ldexp(1.0, level));
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_pixels -= pixelCount(it->result.image);
+        m_order.splice(m_order.begin(), m_order, it->position);
+    } else {
+        m_order.push_front(key);
+    }
+    entry.position = m_order.begin();
+    m_pixels += pixelCount(entry.result.image);
+    m_entries.insert(key, entry);
+    evict();
+    return entry.result;
+}
+
+void EffectCache::evict() {
+    while (m_pixels > MaxPixels && m_entries.size() > 1) {
+        auto oldest = m_entries.find(m_order.back());
+        m_pixels -= pixelCount(oldest->result.image);
+        m_entries.erase(oldest);
+        m_order.pop_back();
+    }
+}
@@ -0,0 +1,135 @@
+#include "../../include/Rendering/FloodFill.h"
+#include "../../include/Rendering/LodPolicy.h"
+#include <algorithm>
+
+namespace FloodFill {
+
+namespace {
+
+struct Seed {
+    int32_t x;
+    int32_t y;
+};
+
+// Pixel-edge directions, clockwise on screen: right, down, left, up.
+constexpr int32_t StepX[4] = {1, 0, -1, 0};
+constexpr int32_t StepY[4] = {0, 1, 0, -1};
+
+}
+
+Mask fill(const QImage& image, const QPoint& seed, bool* reachedBorder) {
+    Mask mask;
+    mask.width = image.width();
+    mask.height = image.height();
+    mask.bits = QVector<uchar>(qsizetype(mask.width) * mask.height, 0);
+    if (reachedBorder) *reachedBorder = false;
+    if (!image.rect().contains(seed) || image.depth() != 32) return mask;
+
+    const int32_t w = mask.width;
+    const int32_t h = mask.height;
+    const QRgb target = reinterpret_cast<const QRgb*>(image.constScanLine(seed.y()))[seed.x()];
+    auto matches = [&](int32_t x, int32_t y, const QRgb* row) {
+        return !mask.bits[y * w + x] && row[x] == target;
+    };
+
+    bool border = false;
+    QVector<Seed> stack;
+    stack.append({seed.x(), seed.y()});
+    while (!stack.isEmpty()) {
+        const Seed s = stack.takeLast();
+        const QRgb* row = reinterpret_cast<const QRgb*>(image.constScanLine(s.y));
+        if (!matches(s.x, s.y, row)) continue;
+
+        int32_t left = s.x;
+        int32_t right = s.x;
+        while (left > 0 && matches(left - 1, s.y, row)) --left;
+        while (right + 1 < w && matches(right + 1, s.y, row)) ++right;
+        std::fill(mask.bits.begin() + s.y * w + left, mask.bits.begin() + s.y * w + right + 1, uchar(1));
+        border = border || left == 0 || right == w - 1 || s.y == 0 || s.y == h - 1;
+
+        // One seed per run of matching pixels next to the span.
+        for (int32_t y : {s.y - 1, s.y + 1}) {
+            if (y < 0 || y >= h) continue;
+            const QRgb* next = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+            bool inRun = false;
+            for (int32_t x = left; x <= right; ++x) {
+                const bool match = matches(x, y, next);
+                if (match && !inRun) stack.append({x, y});
+                inRun = match;
+            }
+        }
+    }
+
+    if (reachedBorder) *reachedBorder = border;
+    return mask;
+}
+
+QList<QPolygon> trace(const Mask& mask) {
+    const int32_t w = mask.width;
+    const int32_t h = mask.height;
+    const int32_t stride = w + 1;
+
+    // Directed edges between region and outside pixels, keyed by their
+    // start corner, with the region on their right.
+    QVector<uchar> edges(qsizetype(stride) * (h + 1), 0);
+    for (int32_t y = 0; y < h; ++y) {
+        for (int32_t x = 0; x < w; ++x) {
+            if (!mask.bits[y * w + x]) continue;
+            if (!mask.at(x, y - 1)) edges[y * stride + x] |= 1 << 0;
+            if (!mask.at(x + 1, y)) edges[y * stride + x + 1] |= 1 << 1;
+            if (!mask.at(x, y + 1)) edges[(y + 1) * stride + x + 1] |= 1 << 2;
+            if (!mask.at(x - 1, y)) edges[(y + 1) * stride + x] |= 1 << 3;
+        }
+    }
+
+    // Every ring has a top edge, so rings start on unused ones. Scanning
+    // in row order meets the outer boundary first.
+    QVector<uchar> used(edges.size(), 0);
+    QList<QPolygon> rings;
+    for (qsizetype start = 0; start < edges.size(); ++start) {
+        if (!(edges[start] & ~used[start] & 1)) continue;
+
+        const QPoint origin(start % stride, start / stride);
+        QPolygon ring;
+        ring << origin;
+        int32_t x = origin.x();
+        int32_t y = origin.y();
+        int32_t dir = 0;
+        for (;;) {
+            used[y * stride + x] |= 1 << dir;
+            x += StepX[dir];
+            y += StepY[dir];
+
+            // Turning right first keeps diagonal neighbours apart, which
+            // matches the 4-connected fill.
+            const uchar out = edges[y * stride + x];
+            int32_t next = dir;
+            for (int32_t turn : {1, 0, 3}) {
+                next = (dir + turn) & 3;
+                if (out & (1 << next)) break;
+            }
+            if (x == origin.x() && y == origin.y() && next == 0) break;
+            if (next != dir) ring << QPoint(x, y);
+            dir = next;
+        }
+        ring << origin;
+        rings.append(ring);
+    }
+    return rings;
+}
+
+QList<QPolygon> simplify(const QList<QPolygon>& rings, qreal tolerance) {
+    QList<QPolygon> result;
+    for (const QPolygon& ring : rings) {
+        const QVector<QPoint> points = Lod::simplify(ring, tolerance);
+        // Rings that collapse under the tolerance are specks of noise.
+        if (points.size() < 4) {
+            if (&ring == &rings.first()) break;
+            continue;
+        }
+        result.append(QPolygon(points));
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,224 @@
+#include "../../include/Rendering/ImagePyramid.h"
+#include <QHash>
+#include <QImageReader>
+#include <QThreadPool>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+ImagePyramidNotifier* ImagePyramid::notifier()
+{
+    static ImagePyramidNotifier* instance = new ImagePyramidNotifier();
+    return instance;
+}
+
+std::shared_ptr<ImagePyramid> ImagePyramid::load(const QString& path)
+{
+    notifier();
+
+    static std::mutex mutex;
+    static QHash<QString, std::weak_ptr<ImagePyramid>> loaded;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (std::shared_ptr<ImagePyramid> pyramid = loaded.value(path).lock()) {
+        return pyramid;
+    }
+
+    QImageReader reader(path);
+    if (!reader.canRead() || !reader.size().isValid()) return nullptr;
+
+    auto pyramid = std::make_shared<ImagePyramid>(path, reader.size());
+    loaded.insert(path, pyramid);
+    QThreadPool::globalInstance()->start([pyramid]() { pyramid->build(); });
+    return pyramid;
+}
+
+ImagePyramid::ImagePyramid(const QString& path, const QSize& size)
+    : m_path(path), m_size(size), m_tiled(qint64(size.width()) * size.height() > MaxDecodedPixels)
+{
+}
+
+void ImagePyramid::build()
+{
+    QVector<QImage> levels;
+    QImageReader reader(m_path);
+    if (m_tiled) {
+        reader.setScaledSize(m_size.scaled(OverviewSize, OverviewSize, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (!image.isNull()) {
+        levels.append(image.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+        while (qMax(levels.last().width(), levels.last().height()) > MinLevelSize) {
+            const QImage& previous = levels.last();
+            levels.append(previous.scaled(qMax(1, previous.width() / 2), qMax(1, previous.height() / 2),
+                                          Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_levels = levels;
+    }
+    m_ready.store(true, std::memory_order_release);
+
+    ImagePyramidNotifier* target = notifier();
+    QMetaObject::invokeMethod(target, [target, pyramid = this]() {
+        emit target->loaded(pyramid);
+    }, Qt::QueuedConnection);
+}
+
+QImage ImagePyramid::level(const QSizeF& size) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (qsizetype i = m_levels.size() - 1; i >= 0; --i) {
+        const QImage& image = m_levels[i];
+        if (image.width() >= size.width() && image.height() >= size.height()) return image;
+    }
+    return m_levels.isEmpty() ? QImage() : m_levels.first();
+}
+
+int32_t ImagePyramid::detailLevel(const QSizeF& size) const
+{
+    if (size.width() <= 0 || size.height() <= 0) return 0;
+    const qreal ratio = qMin(m_size.width() / size.width(), m_size.height() / size.height());
+    if (ratio < 2.0) return 0;
+
+    // Never halve past a single pixel.
+    const int32_t coarsest = qFloor(std::log2(qMax(m_size.width(), m_size.height())));
+    return qMin(qFloor(std::log2(ratio)), coarsest);
+}
+
+QSize ImagePyramid::levelSize(int32_t level) const
+{
+    const qreal factor = std::ldexp(1.0, -level);
+    return QSize(qMax(1, qCeil(m_size.width() * factor)), qMax(1, qCeil(m_size.height() * factor)));
+}
+
+QRect ImagePyramid::tileRange(int32_t level, const QRectF& rect) const
+{
+    const QRectF clipped = rect & QRectF(QPointF(0, 0), levelSize(level));
+    if (clipped.isEmpty()) return QRect();
+    return QRect(QPoint(qFloor(clipped.left() / DetailTileSize), qFloor(clipped.top() / DetailTileSize)),
+                 QPoint(qCeil(clipped.right() / DetailTileSize) - 1, qCeil(clipped.bottom() / DetailTileSize) - 1));
+}
+
+QRect ImagePyramid::tileRect(int32_t level, const QPoint& tile) const
+{
+    return QRect(tile * DetailTileSize, QSize(DetailTileSize, DetailTileSize))
+           & QRect(QPoint(0, 0), levelSize(level));
+}
+
+QImage ImagePyramid::detailTile(int32_t level, const QPoint& tile, bool wait)
+{
+    const DetailKey key{level, tile.x(), tile.y()};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Detail& detail = m_details[key];
+        detail.lastUsed = ++m_clock;
+        if (!detail.image.isNull()) return detail.image;
+        if (!wait) {
+            if (!detail.pending) requestDetail(key);
+            return QImage();
+        }
+    }
+
+    QImage image = readDetail(key);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_details.find(key);
+    if (it != m_details.end()) {
+        it->image = image;
+        evictDetails();
+    }
+    return image;
+}
+
+void ImagePyramid::prefetch(int32_t level, const QRect& range)
+{
+    // Never prefetch more than half the working set, or it would evict
+    // the tiles on screen.
+    if (range.isEmpty() || qint64(range.width()) * range.height() > MaxDetailTiles / 2) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int32_t y = range.top(); y <= range.bottom(); ++y) {
+        for (int32_t x = range.left(); x <= range.right(); ++x) {
+            const DetailKey key{level, x, y};
+            Detail& detail = m_details[key];
+            detail.lastUsed = ++m_clock;
+            if (detail.image.isNull() && !detail.pending) requestDetail(key);
+        }
+    }
+}
+
+QImage ImagePyramid::readDetail(const DetailKey& key) const
+{
+    const QRect rect = tileRect(key.level, QPoint(key.x, key.y));
+    QImageReader reader(m_path);
+    if (key.level == 0) {
+        reader.setClipRect(rect);
+    } else {
+        reader.setScaledSize(levelSize(key.level));
+        reader.setScaledClipRect(rect);
+    }
+    QImage image = reader.read();
+    return image.isNull() ? image : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+void ImagePyramid::requestDetail(const DetailKey& key)
+{
+    m_details[key].pending = true;
+    QThreadPool::globalInstance()->start([self = shared_from_this(), key]() {
+        self->decodeDetail(key);
+    });
+}
+
+void ImagePyramid::decodeDetail(const DetailKey& key)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_details.find(key);
+        if (it == m_details.end()) return;
+        // Scrolled away while queued; a later draw asks again.
+        if (m_clock - it->lastUsed > quint64(MaxDetailTiles) * 4) {
+            m_details.erase(it);
+            return;
+        }
+    }
+
+    QImage image = readDetail(key);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_details.find(key);
+        if (it == m_details.end()) return;
+        // A failed read stays pending so it is not retried on every draw.
+        if (image.isNull()) return;
+        it->image = image;
+        it->pending = false;
+        evictDetails();
+    }
+
+    const QRect rect = tileRect(key.level, QPoint(key.x, key.y));
+    const qreal factor = std::ldexp(1.0, key.level);
+    const QRectF area(rect.x() * factor, rect.y() * factor, rect.width() * factor, rect.height() * factor);
+    ImagePyramidNotifier* target = notifier();
+    QMetaObject::invokeMethod(target, [target, pyramid = this, area]() {
+        emit target->regionLoaded(pyramid, area);
+    }, Qt::QueuedConnection);
+}
+
+void ImagePyramid::evictDetails()
+{
+    if (m_details.size() <= MaxDetailTiles) return;
+
+    QVector<QPair<quint64, DetailKey>> candidates;
+    for (auto it = m_details.cbegin(); it != m_details.cend(); ++it) {
+        if (!it->pending) candidates.append({it->lastUsed, it.key()});
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    for (const auto& candidate : candidates) {
+        if (m_details.size() <= MaxDetailTiles) break;
+        m_details.remove(candidate.second);
+    }
+}
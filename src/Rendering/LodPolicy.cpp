@@ -0,0 +1,76 @@
+#include "../../include/Rendering/LodPolicy.h"
+#include <QPair>
+#include <cmath>
+
+namespace Lod {
+
+int32_t levelForScale(qreal scale) {
+    int32_t level = static_cast<int32_t>(std::ceil(std::log2(scale) - 1e-6));
+    return qMax(MinLevel, level);
+}
+
+qreal toleranceForLevel(int32_t level) {
+    return std::ldexp(0.5, -level);
+}
+
+QVector<QPoint> simplify(const QVector<QPoint>& points, qreal tolerance) {
+    const qsizetype count = points.size();
+    if (count < 3) return points;
+
+    const qreal toleranceSquared = tolerance * tolerance;
+    QVector<bool> keep(count, false);
+    keep[0] = keep[count - 1] = true;
+
+    QVector<QPair<qsizetype, qsizetype>> stack;
+    stack.append({0, count - 1});
+    while (!stack.isEmpty()) {
+        auto [first, last] = stack.takeLast();
+
+        const QPointF a = points[first];
+        const QPointF ab = QPointF(points[last]) - a;
+        const qreal lengthSquared = ab.x() * ab.x() + ab.y() * ab.y();
+
+        qreal maxDistance = 0.0;
+        qsizetype farthest = first;
+        for (qsizetype i = first + 1; i < last; ++i) {
+            QPointF ap = QPointF(points[i]) - a;
+            qreal distance;
+            if (lengthSquared == 0.0) {
+                distance = ap.x() * ap.x() + ap.y() * ap.y();
+            } else {
+                // Distance to the segment, not the infinite line, so that
+                // hooks and reversals are never flattened away.
+                qreal t = qBound(0.0, (ap.x() * ab.x() + ap.y() * ab.y()) / lengthSquared, 1.0);
+                QPointF d = ap - ab * t;
+                distance = d.x() * d.x() + d.y() * d.y();
+            }
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
+
+        if (maxDistance > toleranceSquared) {
+            keep[farthest] = true;
+            if (farthest - first > 1) stack.append({first, farthest});
+            if (last - farthest > 1) stack.append({farthest, last});
+        }
+    }
+
+    QVector<QPoint> result;
+    for (qsizetype i = 0; i < count; ++i) {
+        if (keep[i]) result.append(points[i]);
+    }
+    return result;
+}
+
+bool isTiny(const QRect& bounds, qreal scale) {
+    return qMax(bounds.width(), bounds.height()) * scale <= MinFeatureSize;
+}
+
+QColor boxColor(const Shape& shape) {
+    QColor fill = shape.getFillColor();
+    return shape.isShapeFilled() && fill.alpha() == 255 ? fill : shape.getColor();
+}
+
+}
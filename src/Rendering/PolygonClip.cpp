@@ -0,0 +1,499 @@
+#include "../../include/Rendering/PolygonClip.h"
+#include "../../include/Rendering/CurveFit.h"
+#include <QHash>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace PolygonClip {
+
+namespace {
+
+struct Point {
+    qint64 x = 0;
+    qint64 y = 0;
+
+    bool operator==(const Point& other) const { return x == other.x && y == other.y; }
+    bool operator!=(const Point& other) const { return !(*this == other); }
+    bool operator<(const Point& other) const { return x < other.x || (x == other.x && y < other.y); }
+};
+
+size_t qHash(const Point& point, size_t seed = 0) {
+    return qHashMulti(seed, point.x, point.y);
+}
+
+struct Edge {
+    Point a;
+    Point b;
+    int32_t owner = 0;
+};
+
+using Ring = QVector<Point>;
+
+qint64 cross(const Point& o, const Point& a, const Point& b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+QVector<Ring> toFixed(const QList<QPolygonF>& rings) {
+    QVector<Ring> result;
+    for (const QPolygonF& polygon : rings) {
+        Ring ring;
+        ring.reserve(polygon.size());
+        for (const QPointF& point : polygon) {
+            const Point p{qRound64(point.x() * FixedScale), qRound64(point.y() * FixedScale)};
+            if (ring.isEmpty() || ring.last() != p) ring.append(p);
+        }
+        while (ring.size() > 1 && ring.last() == ring.first()) ring.removeLast();
+        if (ring.size() >= 3) result.append(ring);
+    }
+    return result;
+}
+
+void addEdges(const QVector<Ring>& rings, int32_t owner, QVector<Edge>& edges) {
+    for (const Ring& ring : rings) {
+        for (qsizetype i = 0; i < ring.size(); ++i) {
+            edges.append({ring[i], ring[(i + 1) % ring.size()], owner});
+        }
+    }
+}
+
+bool sameEdge(const Edge& e, const Edge& f) {
+    return (e.a == f.a && e.b == f.b) || (e.a == f.b && e.b == f.a);
+}
+
+// Odd-even containment against one operand's snapped boundary, exact on
+// the integer grid. A ray runs from the point towards +x, or towards +y
+// when built transposed, and edges are bucketed into bands across the ray
+// so a test only looks at the edges it can cross.
+class Region
+{
+public:
+    Region(const QVector<Edge>& edges, bool transposed) : m_transposed(transposed) {
+        if (edges.isEmpty()) return;
+
+        m_edges.reserve(edges.size());
+        for (const Edge& edge : edges) {
+            m_edges.append({map(edge.a), map(edge.b), edge.owner});
+        }
+        qint64 top = m_edges.first().a.y;
+        qint64 bottom = top;
+        for (const Edge& edge : m_edges) {
+            top = std::min({top, edge.a.y, edge.b.y});
+            bottom = std::max({bottom, edge.a.y, edge.b.y});
+        }
+        const int32_t bands = qBound(1, qCeil(std::sqrt(qreal(edges.size()))), 1024);
+        m_top = top;
+        m_bottom = bottom;
+        m_bandHeight = qMax<qint64>(1, (bottom - top) / bands + 1);
+        m_bands.resize(bands);
+
+        for (int32_t i = 0; i < m_edges.size(); ++i) {
+            const Edge& edge = m_edges[i];
+            const int32_t first = band(std::min(edge.a.y, edge.b.y));
+            const int32_t last = band(std::max(edge.a.y, edge.b.y));
+            for (int32_t b = first; b <= last; ++b) m_bands[b].append(i);
+        }
+    }
+
+    // Parity of the edges the ray from p crosses, leaving out skip.
+    bool contains(const Point& point, const Edge* skip = nullptr) const {
+        const Point p = map(point);
+        if (m_bands.isEmpty() || p.y < m_top || p.y > m_bottom) return false;
+
+        Edge skipped;
+        if (skip) skipped = {map(skip->a), map(skip->b), skip->owner};
+
+        bool inside = false;
+        for (int32_t i : m_bands[band(p.y)]) {
+            const Edge& edge = m_edges[i];
+            if ((edge.a.y > p.y) == (edge.b.y > p.y)) continue;
+            if (skip && sameEdge(edge, skipped)) continue;
+            const qint64 side = cross(edge.a, edge.b, p);
+            if (edge.b.y > edge.a.y ? side > 0 : side < 0) inside = !inside;
+        }
+        return inside;
+    }
+
+private:
+    Point map(const Point& p) const { return m_transposed ? Point{p.y, p.x} : p; }
+    int32_t band(qint64 y) const {
+        return qBound<qint64>(0, (y - m_top) / m_bandHeight, m_bands.size() - 1);
+    }
+
+    bool m_transposed = false;
+    QVector<Edge> m_edges;
+    qint64 m_top = 0;
+    qint64 m_bottom = 0;
+    qint64 m_bandHeight = 1;
+    QVector<QVector<int32_t>> m_bands;
+};
+
+// Signed 128-bit value, enough for the product of a grid coordinate
+// and a cross product, which already uses most of 64 bits.
+struct Wide {
+    qint64 hi = 0;
+    quint64 lo = 0;
+
+    bool operator<(const Wide& other) const { return hi < other.hi || (hi == other.hi && lo < other.lo); }
+};
+
+Wide multiply(qint64 a, qint64 b) {
+    const quint64 x = a < 0 ? 0 - quint64(a) : quint64(a);
+    const quint64 y = b < 0 ? 0 - quint64(b) : quint64(b);
+    const quint64 x0 = x & 0xffffffffu, x1 = x >> 32;
+    const quint64 y0 = y & 0xffffffffu, y1 = y >> 32;
+    const quint64 low = x0 * y0;
+    const quint64 middle = (low >> 32) + ((x0 * y1) & 0xffffffffu) + ((x1 * y0) & 0xffffffffu);
+    quint64 lo = (middle << 32) | (low & 0xffffffffu);
+    quint64 hi = x1 * y1 + ((x0 * y1) >> 32) + ((x1 * y0) >> 32) + (middle >> 32);
+    if ((a < 0) != (b < 0)) {
+        lo = ~lo + 1;
+        hi = ~hi + (lo == 0 ? 1 : 0);
+    }
+    return {qint64(hi), lo};
+}
+
+// The k with k - 1/2 <= num / den < k + 1/2, so the pixel centred on k
+// holds the value, the same half-open pixel passesThrough() tests.
+qint64 roundQuotient(qint64 num, qint64 den, qint64 scale) {
+    if (den < 0) {
+        num = -num;
+        den = -den;
+    }
+    // The estimate is off by at most one; exact products settle it.
+    qint64 k = std::llround(static_cast<long double>(scale) * num / den);
+    const Wide twice = multiply(2 * scale, num);
+    while (twice < multiply(den, 2 * k - 1)) --k;
+    while (!(twice < multiply(den, 2 * k + 1))) ++k;
+    return k;
+}
+
+// A proper crossing of e and f, rounded exactly to the grid. Touching and
+// overlapping edges meet at endpoints, which are hot pixels already.
+bool crossing(const Edge& e, const Edge& f, Point& point) {
+    const qint64 d1 = cross(e.a, e.b, f.a);
+    const qint64 d2 = cross(e.a, e.b, f.b);
+    const qint64 d3 = cross(f.a, f.b, e.a);
+    const qint64 d4 = cross(f.a, f.b, e.b);
+    if (d1 == 0 || d2 == 0 || d3 == 0 || d4 == 0) return false;
+    if ((d1 > 0) == (d2 > 0) || (d3 > 0) == (d4 > 0)) return false;
+
+    // The crossing sits at e.a + (e.b - e.a) * d3 / (d3 - d4).
+    point = {e.a.x + roundQuotient(d3, d3 - d4, e.b.x - e.a.x),
+             e.a.y + roundQuotient(d3, d3 - d4, e.b.y - e.a.y)};
+    return true;
+}
+
+// Whether the edge meets the unit pixel centred on the grid point p,
+// closed on its low sides and open on its high ones. Doubled coordinates
+// keep the pixel corners on the integer grid.
+bool passesThrough(const Edge& e, const Point& p) {
+    const qint64 left = 2 * p.x - 1, right = 2 * p.x + 1;
+    const qint64 top = 2 * p.y - 1, bottom = 2 * p.y + 1;
+    const Point a{2 * e.a.x, 2 * e.a.y};
+    const Point b{2 * e.b.x, 2 * e.b.y};
+    if (std::max(a.x, b.x) < left || std::min(a.x, b.x) >= right) return false;
+    if (std::max(a.y, b.y) < top || std::min(a.y, b.y) >= bottom) return false;
+
+    const Point corners[4] = {{left, top}, {right, top}, {left, bottom}, {right, bottom}};
+    bool below = false, above = false;
+    for (const Point& corner : corners) {
+        const qint64 side = cross(a, b, corner);
+        below |= side <= 0;
+        above |= side >= 0;
+    }
+    return below && above;
+}
+
+// Snap rounding: every endpoint and rounded crossing is a hot pixel, and
+// each edge is redrawn through the centres of all hot pixels it passes.
+// Fragments then only meet at shared vertices, even where rounding moved
+// a crossing onto a third, nearly parallel edge.
+QVector<Edge> splitEdges(const QVector<Edge>& edges) {
+    Ring hot;
+    hot.reserve(edges.size() * 2);
+    for (const Edge& edge : edges) {
+        hot.append(edge.a);
+        hot.append(edge.b);
+    }
+
+    QVector<int32_t> order(edges.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&edges](int32_t a, int32_t b) {
+        return std::min(edges[a].a.x, edges[a].b.x) < std::min(edges[b].a.x, edges[b].b.x);
+    });
+
+    // Sweep left to right, keeping the edges whose x range is still open.
+    QVector<int32_t> active;
+    for (int32_t i : order) {
+        const Edge& e = edges[i];
+        const qint64 left = std::min(e.a.x, e.b.x);
+        const qint64 top = std::min(e.a.y, e.b.y);
+        const qint64 bottom = std::max(e.a.y, e.b.y);
+
+        active.erase(std::remove_if(active.begin(), active.end(), [&edges, left](int32_t j) {
+            return std::max(edges[j].a.x, edges[j].b.x) < left;
+        }), active.end());
+
+        for (int32_t j : active) {
+            const Edge& f = edges[j];
+            if (std::max(f.a.y, f.b.y) < top || std::min(f.a.y, f.b.y) > bottom) continue;
+            Point point;
+            if (crossing(e, f, point)) hot.append(point);
+        }
+        active.append(i);
+    }
+
+    std::sort(hot.begin(), hot.end());
+    hot.erase(std::unique(hot.begin(), hot.end()), hot.end());
+
+    QVector<Edge> result;
+    result.reserve(edges.size());
+    Ring through;
+    for (const Edge& e : edges) {
+        // Endpoints lie on the grid, so only pixels centred inside the
+        // edge's x range can meet it.
+        const Point start{std::min(e.a.x, e.b.x), std::numeric_limits<qint64>::min()};
+        const auto first = std::lower_bound(hot.cbegin(), hot.cend(), start);
+        const qint64 right = std::max(e.a.x, e.b.x);
+        through.clear();
+        for (auto it = first; it != hot.cend() && it->x <= right; ++it) {
+            if (passesThrough(e, *it)) through.append(*it);
+        }
+
+        const Point direction{e.b.x - e.a.x, e.b.y - e.a.y};
+        std::sort(through.begin(), through.end(), [&e, &direction](const Point& p, const Point& q) {
+            return (p.x - e.a.x) * direction.x + (p.y - e.a.y) * direction.y
+                 < (q.x - e.a.x) * direction.x + (q.y - e.a.y) * direction.y;
+        });
+
+        Point from = e.a;
+        for (const Point& point : through) {
+            if (point == from || point == e.b) continue;
+            result.append({from, point, e.owner});
+            from = point;
+        }
+        if (from != e.b) result.append({from, e.b, e.owner});
+    }
+    return result;
+}
+
+// Ranks outgoing directions by their signed turn from the incoming one,
+// as atan2 of cross and dot would, using integer signs only: one side,
+// straight on, the other side, then straight back.
+int32_t turnHalf(const Point& in, const Point& out) {
+    const qint64 side = in.x * out.y - in.y * out.x;
+    if (side != 0) return side < 0 ? 0 : 2;
+    return in.x * out.x + in.y * out.y > 0 ? 1 : 3;
+}
+
+bool turnsLess(const Point& in, const Point& a, const Point& b) {
+    const int32_t halfA = turnHalf(in, a);
+    const int32_t halfB = turnHalf(in, b);
+    if (halfA != halfB) return halfA < halfB;
+    return a.x * b.y - a.y * b.x > 0;
+}
+
+QVector<Ring> link(const QVector<Edge>& edges) {
+    QHash<Point, QVector<int32_t>> adjacency;
+    for (int32_t i = 0; i < edges.size(); ++i) {
+        adjacency[edges[i].a].append(i);
+        adjacency[edges[i].b].append(i);
+    }
+
+    QVector<Ring> rings;
+    QVector<bool> used(edges.size(), false);
+    for (int32_t start = 0; start < edges.size(); ++start) {
+        if (used[start]) continue;
+        used[start] = true;
+
+        Ring ring{edges[start].a};
+        Point previous = edges[start].a;
+        Point current = edges[start].b;
+        while (current != ring.first()) {
+            ring.append(current);
+
+            // Always taking the leftmost turn keeps rings that only touch
+            // at a vertex apart.
+            const Point in{current.x - previous.x, current.y - previous.y};
+            int32_t next = -1;
+            Point bestOut;
+            for (int32_t candidate : adjacency.value(current)) {
+                if (used[candidate]) continue;
+                const Edge& edge = edges[candidate];
+                const Point& to = edge.a == current ? edge.b : edge.a;
+                const Point out{to.x - current.x, to.y - current.y};
+                if (next < 0 || turnsLess(in, bestOut, out)) {
+                    next = candidate;
+                    bestOut = out;
+                }
+            }
+            if (next < 0) break;
+
+            used[next] = true;
+            previous = current;
+            current = edges[next].a == current ? edges[next].b : edges[next].a;
+        }
+        // A dead end leaves an open chain, which is no outline.
+        if (current == ring.first() && ring.size() >= 3) rings.append(ring);
+    }
+    return rings;
+}
+
+}
+
+QList<QPolygonF> flatten(const QPainterPath& path, qreal tolerance) {
+    QList<QPolygonF> rings;
+    QPolygonF ring;
+    for (int32_t i = 0; i < path.elementCount(); ++i) {
+        const QPainterPath::Element element = path.elementAt(i);
+        switch (element.type) {
+        case QPainterPath::MoveToElement:
+            if (ring.size() >= 3) rings.append(ring);
+            ring = QPolygonF{QPointF(element)};
+            break;
+        case QPainterPath::LineToElement:
+            ring.append(element);
+            break;
+        case QPainterPath::CurveToElement: {
+            const QPointF segment[4] = {ring.last(), element, path.elementAt(i + 1), path.elementAt(i + 2)};
+            const int32_t steps = CurveFit::flattenSteps(segment, tolerance);
+            for (int32_t k = 1; k <= steps; ++k) {
+                ring.append(CurveFit::pointAt(segment, qreal(k) / steps));
+            }
+            i += 2;
+            break;
+        }
+        case QPainterPath::CurveToDataElement:
+            break;
+        }
+    }
+    if (ring.size() >= 3) rings.append(ring);
+    return rings;
+}
+
+QList<QPolygonF> apply(const QList<QPolygonF>& a, const QList<QPolygonF>& b, Operation operation) {
+    QVector<Edge> edges;
+    addEdges(toFixed(a), 0, edges);
+    addEdges(toFixed(b), 1, edges);
+
+    // Under the odd-even rule an edge drawn twice by the same operand, such
+    // as a bridge to a hole, is no boundary at all.
+    struct Count {
+        int32_t times[2] = {0, 0};
+    };
+    QHash<QPair<Point, Point>, Count> counts;
+    for (const Edge& edge : splitEdges(edges)) {
+        const QPair<Point, Point> key = edge.a < edge.b ? qMakePair(edge.a, edge.b) : qMakePair(edge.b, edge.a);
+        ++counts[key].times[edge.owner];
+    }
+
+    // Fragments are classified against the snapped boundaries rather than
+    // the input, so every test agrees with the arrangement being linked.
+    // Coordinates are doubled to put fragment midpoints on the grid.
+    QVector<Edge> boundaries[2];
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        const Point p{2 * it.key().first.x, 2 * it.key().first.y};
+        const Point q{2 * it.key().second.x, 2 * it.key().second.y};
+        for (int32_t owner = 0; owner < 2; ++owner) {
+            if (it->times[owner] % 2) boundaries[owner].append({p, q, owner});
+        }
+    }
+    const Region across[2] = {Region(boundaries[0], false), Region(boundaries[1], false)};
+    const Region along[2] = {Region(boundaries[0], true), Region(boundaries[1], true)};
+
+    QVector<Edge> kept;
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        const bool inA = it->times[0] % 2;
+        const bool inB = it->times[1] % 2;
+        if (!inA && !inB) continue;
+
+        const Point& p = it.key().first;
+        const Point& q = it.key().second;
+        const Point mid{p.x + q.x, p.y + q.y};
+
+        bool keep;
+        if (inA && inB) {
+            // A shared edge stays when both interiors lie on the same side,
+            // except for a difference, where the sides must differ. Leaving
+            // the edge itself out, a ray crossing it gives the containment
+            // on one side for both operands alike; horizontal edges need a
+            // vertical ray.
+            const Edge self{{2 * p.x, 2 * p.y}, {2 * q.x, 2 * q.y}, 0};
+            const Region* regions = p.y == q.y ? along : across;
+            const bool sameSide = regions[0].contains(mid, &self) == regions[1].contains(mid, &self);
+            keep = operation == Difference ? !sameSide : sameSide;
+        } else if (inA) {
+            const bool inside = across[1].contains(mid);
+            keep = operation == Intersection ? inside : !inside;
+        } else {
+            const bool inside = across[0].contains(mid);
+            keep = operation == Union ? !inside : inside;
+        }
+        if (keep) kept.append({p, q, 0});
+    }
+
+    QList<QPolygonF> result;
+    for (const Ring& ring : link(kept)) {
+        QPolygonF polygon;
+        polygon.reserve(ring.size());
+        for (const Point& point : ring) {
+            polygon.append(QPointF(qreal(point.x) / FixedScale, qreal(point.y) / FixedScale));
+        }
+        result.append(polygon);
+    }
+    return result;
+}
+
+QList<QList<QPolygon>> pieces(const QList<QPolygonF>& rings) {
+    // Depth counts the other rings around a point on each ring's first
+    // edge; even depths are outlines, odd ones are holes.
+    QVector<QPointF> probes;
+    QVector<qreal> areas;
+    for (const QPolygonF& ring : rings) {
+        probes.append((ring[0] + ring[1]) / 2);
+        qreal area = 0.0;
+        for (qsizetype i = 0; i < ring.size(); ++i) {
+            const QPointF& a = ring[i];
+            const QPointF& b = ring[(i + 1) % ring.size()];
+            area += a.x() * b.y() - b.x() * a.y();
+        }
+        areas.append(std::abs(area) / 2);
+    }
+
+    QVector<QVector<qsizetype>> containers(rings.size());
+    for (qsizetype i = 0; i < rings.size(); ++i) {
+        for (qsizetype j = 0; j < rings.size(); ++j) {
+            if (i != j && rings[j].containsPoint(probes[i], Qt::OddEvenFill)) containers[i].append(j);
+        }
+    }
+
+    auto closed = [](const QPolygonF& ring) {
+        QPolygon polygon = ring.toPolygon();
+        polygon.append(polygon.first());
+        return polygon;
+    };
+
+    QList<QList<QPolygon>> result;
+    QHash<qsizetype, qsizetype> pieceOf;
+    for (qsizetype i = 0; i < rings.size(); ++i) {
+        if (containers[i].size() % 2) continue;
+        pieceOf.insert(i, result.size());
+        result.append({closed(rings[i])});
+    }
+    for (qsizetype i = 0; i < rings.size(); ++i) {
+        if (containers[i].size() % 2 == 0) continue;
+
+        // A hole belongs to the smallest outline around it.
+        qsizetype owner = -1;
+        for (qsizetype j : containers[i]) {
+            if (containers[j].size() % 2 == 0 && (owner < 0 || areas[j] < areas[owner])) owner = j;
+        }
+        if (owner >= 0) result[pieceOf.value(owner)].append(closed(rings[i]));
+    }
+    return result;
+}
+
+}
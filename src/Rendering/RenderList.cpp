@@ -0,0 +1,141 @@
+#include "../../include/Rendering/RenderList.h"
+#include "../../include/Rendering/LodPolicy.h"
+#include "../../include/SpatialIndex.h"
+
+QPainterPath PathCache::path(const Shape& shape, qreal scale) {
+    const QPair<const Shape*, int32_t> key(&shape, Lod::levelForScale(scale));
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end() && it->version == shape.version()) {
+            m_order.splice(m_order.begin(), m_order, it->position);
+            return it->path;
+        }
+    }
+
+    // Built outside the lock; a racing worker at worst builds it twice.
+    Entry entry;
+    entry.version = shape.version();
+    entry.path = shape.renderPath(scale);
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_bytes -= byteCount(it->path);
+        m_order.splice(m_order.begin(), m_order, it->position);
+    } else {
+        m_order.push_front(key);
+    }
+    entry.position = m_order.begin();
+    m_bytes += byteCount(entry.path);
+    m_entries.insert(key, entry);
+    evict();
+    return entry.path;
+}
+
+void PathCache::evict() {
+    while (m_bytes > MaxBytes && m_entries.size() > 1) {
+        auto oldest = m_entries.find(m_order.back());
+        m_bytes -= byteCount(oldest->path);
+        m_entries.erase(oldest);
+        m_order.pop_back();
+    }
+}
+
+void RenderList::compile(const QList<std::shared_ptr<Shape>>& shapes, const QVector<QRect>& bounds,
+                         qreal scale, PathCache& cache, EffectCache& effects)
+{
+    m_batches.clear();
+    m_scale = scale;
+
+    const int32_t margin = SpatialIndex::BoundsMargin;
+    for (qsizetype i = 0; i < shapes.size(); ++i) {
+        const Shape& shape = *shapes[i];
+        const QRect shapeBounds = bounds[i].adjusted(margin, margin, -margin, -margin);
+
+        if (Lod::isTiny(shapeBounds, scale)) {
+            QPainterPath box;
+            box.setFillRule(Qt::WindingFill);
+            box.addRect(shapeBounds);
+            append(Qt::NoPen, Lod::boxColor(shape), box, shapeBounds);
+            continue;
+        }
+
+        if (shape.style().hasEffects()) {
+            Batch batch;
+            batch.effect = effects.result(shape, scale);
+            m_batches.append(batch);
+            continue;
+        }
+
+        // Gradients follow the shape's own frame, which a world-space path
+        // of a rotated shape has lost.
+        const QBrush brush = shape.renderBrush();
+        QPainterPath path = brush.gradient() && shape.rotation() != 0.0 ? QPainterPath()
+                                                                         : cache.path(shape, scale);
+        if (path.isEmpty()) {
+            Batch batch;
+            batch.fallback = &shape;
+            m_batches.append(batch);
+            continue;
+        }
+        append(shape.renderPen(), brush, path, shapeBounds);
+    }
+}
+
+void RenderList::append(const QPen& pen, const QBrush& brush, const QPainterPath& path, const QRect& bounds) {
+    // Overlapping fills in one path would cancel each other under the
+    // path's fill rule, so any filled path only merges with disjoint ones.
+    bool overlapSensitive = brush.style() != Qt::NoBrush
+                         || (pen.style() != Qt::NoPen && pen.color().alpha() < 255);
+
+    if (!m_batches.isEmpty()) {
+        Batch& last = m_batches.last();
+        // A gradient spans the bounds of the path it fills, so gradient
+        // fills are never merged.
+        bool sameStyle = !last.fallback && last.effect.image.isNull() && !brush.gradient()
+                      && last.pen == pen && last.brush == brush && last.path.fillRule() == path.fillRule();
+        if (sameStyle && (!overlapSensitive || !last.bounds.intersects(bounds))) {
+            last.path.addPath(path);
+            last.bounds |= bounds;
+            return;
+        }
+    }
+
+    Batch batch;
+    batch.pen = pen;
+    batch.brush = brush;
+    batch.path = path;
+    batch.bounds = bounds;
+    batch.overlapSensitive = overlapSensitive;
+    m_batches.append(batch);
+}
+
+void RenderList::draw(QPainter& painter) const {
+    bool stateKnown = false;
+    QPen currentPen;
+    QBrush currentBrush;
+
+    for (const Batch& batch : m_batches) {
+        if (batch.fallback) {
+            // drawLod() saves and restores, so the tracked state stays valid.
+            batch.fallback->drawLod(painter, m_scale);
+            continue;
+        }
+        if (!batch.effect.image.isNull()) {
+            painter.drawImage(batch.effect.rect, batch.effect.image);
+            continue;
+        }
+
+        if (!stateKnown || currentPen != batch.pen) {
+            painter.setPen(batch.pen);
+            currentPen = batch.pen;
+        }
+        if (!stateKnown || currentBrush != batch.brush) {
+            painter.setBrush(batch.brush);
+            currentBrush = batch.brush;
+        }
+        stateKnown = true;
+        painter.drawPath(batch.path);
+    }
+}
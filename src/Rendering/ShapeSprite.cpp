@@ -0,0 +1,29 @@
+#include "../../include/Rendering/ShapeSprite.h"
+#include "../../include/Rendering/Effects.h"
+#include <QtMath>
+
+ShapeSprite::ShapeSprite(const QList<std::shared_ptr<Shape>>& shapes, const QRect& bounds, qreal scale)
+    : m_bounds(bounds)
+{
+    qreal longest = qMax(bounds.width(), bounds.height()) * scale;
+    if (longest > MaxSize) scale *= MaxSize / longest;
+
+    QSize size(qMax(1, qCeil(bounds.width() * scale)), qMax(1, qCeil(bounds.height() * scale)));
+    m_image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    m_image.fill(Qt::transparent);
+
+    QPainter painter(&m_image);
+    painter.scale(scale, scale);
+    painter.translate(-bounds.topLeft());
+    for (const auto& shape : shapes) {
+        Effects::draw(painter, *shape, scale);
+    }
+}
+
+void ShapeSprite::draw(QPainter& painter) const {
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.setTransform(m_transform, true);
+    painter.drawImage(QRectF(m_bounds), m_image);
+    painter.restore();
+}
@@ -0,0 +1,210 @@
+#include "../../include/Rendering/TileCache.h"
+#include <QCoreApplication>
+#include <QPointer>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+TileCache::TileCache(const SpatialIndex& index, TileRenderer& renderer, QObject* parent)
+    : QObject(parent), m_index(index), m_renderer(renderer)
+{
+}
+
+void TileCache::setClearColor(const QColor& color) {
+    m_clearColor = color;
+    invalidateAll();
+}
+
+void TileCache::invalidate(const QRect& worldRect) {
+    if (worldRect.isEmpty()) return;
+
+    for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+        if (tileWorldRect(it.key()).intersects(worldRect)) {
+            it->dirty = true;
+            ++it->generation;
+        }
+    }
+}
+
+void TileCache::invalidateAll() {
+    for (Tile& tile : m_tiles) {
+        tile.dirty = true;
+        ++tile.generation;
+    }
+}
+
+void TileCache::paint(QPainter& painter, const Viewport& viewport, const QSize& viewportSize) {
+    ++m_frame;
+    const int32_t level = viewport.level();
+    const QRectF visible = viewport.mapToWorld(QRectF(QPointF(0, 0), viewportSize));
+    const QRect range = tileRange(visible, level);
+
+    // Tiles nothing can stand in for are rendered now, in parallel; the
+    // rest are queued and shown through a coarser level meanwhile.
+    QVector<TileKey> syncKeys;
+    for (int32_t ty = range.top(); ty <= range.bottom(); ++ty) {
+        for (int32_t tx = range.left(); tx <= range.right(); ++tx) {
+            TileKey key{level, tx, ty};
+            Tile& tile = m_tiles[key];
+            tile.lastUsed = m_frame;
+            if (!tile.dirty) continue;
+
+            TileKey fallback;
+            if (tile.image.isNull() && findFallback(key, fallback)) {
+                if (!tile.pending) requestAsync(key);
+            } else {
+                syncKeys.append(key);
+            }
+        }
+    }
+
+    if (!syncKeys.isEmpty()) {
+        QVector<TileRenderer::Job> jobs;
+        jobs.reserve(syncKeys.size());
+        for (const TileKey& key : syncKeys) {
+            jobs.append(makeJob(key));
+        }
+
+        QVector<QImage> images = m_renderer.renderBatch(jobs);
+        for (qsizetype i = 0; i < syncKeys.size(); ++i) {
+            Tile& tile = m_tiles[syncKeys[i]];
+            tile.image = images[i];
+            tile.dirty = false;
+        }
+    }
+
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    for (int32_t ty = range.top(); ty <= range.bottom(); ++ty) {
+        for (int32_t tx = range.left(); tx <= range.right(); ++tx) {
+            TileKey key{level, tx, ty};
+
+            // Round both edges so neighbouring tiles share them exactly.
+            QRectF world = tileWorldRect(key);
+            QPointF topLeft = viewport.mapFromWorld(world.topLeft());
+            QPointF bottomRight = viewport.mapFromWorld(world.bottomRight());
+            QRect target(QPoint(qRound(topLeft.x()), qRound(topLeft.y())),
+                         QPoint(qRound(bottomRight.x()) - 1, qRound(bottomRight.y()) - 1));
+
+            const Tile& tile = m_tiles[key];
+            TileKey fallback;
+            if (!tile.dirty) {
+                painter.drawImage(target, tile.image);
+            } else if (findFallback(key, fallback)) {
+                int32_t shift = level - fallback.level;
+                int32_t span = TileSize >> shift;
+                // Tile coordinates go negative left of and above the origin,
+                // where shifting them left is undefined.
+                const int32_t factor = 1 << shift;
+                QRect source((key.x - fallback.x * factor) * span,
+                             (key.y - fallback.y * factor) * span, span, span);
+                painter.drawImage(target, m_tiles[fallback].image, source);
+            } else if (m_clearColor.alpha() > 0) {
+                painter.fillRect(target, m_clearColor);
+            }
+        }
+    }
+    painter.restore();
+
+    // Keep a coarse copy of the surroundings warm.
+    const int32_t coarseLevel = level - PrefetchLevelOffset;
+    QRectF surroundings = visible.adjusted(-visible.width() / 2, -visible.height() / 2,
+                                           visible.width() / 2, visible.height() / 2);
+    QRect coarseRange = tileRange(surroundings, coarseLevel);
+    for (int32_t ty = coarseRange.top(); ty <= coarseRange.bottom(); ++ty) {
+        for (int32_t tx = coarseRange.left(); tx <= coarseRange.right(); ++tx) {
+            TileKey key{coarseLevel, tx, ty};
+            Tile& tile = m_tiles[key];
+            tile.lastUsed = m_frame;
+            if (tile.dirty && !tile.pending) requestAsync(key);
+        }
+    }
+
+    evict();
+}
+
+qreal TileCache::tileWorldSize(int32_t level) {
+    return std::ldexp(qreal(TileSize), -level);
+}
+
+QRectF TileCache::tileWorldRect(const TileKey& key) {
+    qreal size = tileWorldSize(key.level);
+    return QRectF(key.x * size, key.y * size, size, size);
+}
+
+QRect TileCache::tileRange(const QRectF& worldRect, int32_t level) {
+    qreal size = tileWorldSize(level);
+    return QRect(QPoint(qFloor(worldRect.left() / size), qFloor(worldRect.top() / size)),
+                 QPoint(qCeil(worldRect.right() / size) - 1, qCeil(worldRect.bottom() / size) - 1));
+}
+
+bool TileCache::isReady(const TileKey& key) const {
+    auto it = m_tiles.constFind(key);
+    return it != m_tiles.constEnd() && !it->dirty;
+}
+
+bool TileCache::findFallback(const TileKey& key, TileKey& fallback) const {
+    for (int32_t shift = 1; shift <= MaxFallbackLevels; ++shift) {
+        TileKey parent{key.level - shift, key.x >> shift, key.y >> shift};
+        if (isReady(parent)) {
+            fallback = parent;
+            return true;
+        }
+    }
+    return false;
+}
+
+TileRenderer::Job TileCache::makeJob(const TileKey& key) const {
+    TileRenderer::Job job;
+    job.worldRect = tileWorldRect(key);
+    job.scale = std::ldexp(1.0, key.level);
+    job.clearColor = m_clearColor;
+    job.shapes = m_index.query(job.worldRect.toAlignedRect(), &job.bounds);
+    return job;
+}
+
+void TileCache::requestAsync(const TileKey& key) {
+    Tile& tile = m_tiles[key];
+    tile.pending = true;
+    const quint64 generation = tile.generation;
+
+    // The renderer outlives this cache when its layer is deleted, so the
+    // result is delivered through the application and dropped if it is gone.
+    QPointer<TileCache> self(this);
+    m_renderer.renderAsync(makeJob(key), [self, key, generation](QImage image) {
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, key, generation, image]() {
+            if (self) self->finishAsync(key, generation, image);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TileCache::finishAsync(const TileKey& key, quint64 generation, const QImage& image) {
+    auto it = m_tiles.find(key);
+    if (it == m_tiles.end()) return;
+
+    it->pending = false;
+    if (it->generation != generation) return;
+
+    it->image = image;
+    it->dirty = false;
+    emit tilesReady();
+}
+
+void TileCache::evict() {
+    if (m_tiles.size() <= MaxTiles) return;
+
+    QVector<QPair<quint64, TileKey>> candidates;
+    for (auto it = m_tiles.cbegin(); it != m_tiles.cend(); ++it) {
+        if (it->lastUsed != m_frame && !it->pending) {
+            candidates.append({it->lastUsed, it.key()});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    for (const auto& candidate : candidates) {
+        if (m_tiles.size() <= MaxTiles) break;
+        m_tiles.remove(candidate.second);
+    }
+}
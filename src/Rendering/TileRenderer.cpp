@@ -0,0 +1,53 @@
+#include "../../include/Rendering/TileRenderer.h"
+#include <QPainter>
+#include <QSemaphore>
+#include <QThread>
+
+TileRenderer::TileRenderer(QReadWriteLock& documentLock)
+    : m_documentLock(documentLock)
+{
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+TileRenderer::~TileRenderer() {
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QVector<QImage> TileRenderer::renderBatch(const QVector<Job>& jobs) {
+    QVector<QImage> images(jobs.size());
+    QImage* results = images.data();
+    QSemaphore finished;
+
+    for (qsizetype i = 0; i < jobs.size(); ++i) {
+        // Interactive tiles jump ahead of queued prefetch work.
+        m_pool.start([this, &jobs, results, &finished, i]() {
+            results[i] = renderTile(jobs[i]);
+            finished.release();
+        }, 1);
+    }
+
+    finished.acquire(jobs.size());
+    return images;
+}
+
+void TileRenderer::renderAsync(const Job& job, std::function<void(QImage)> done) {
+    m_pool.start([this, job, done = std::move(done)]() {
+        done(renderTile(job));
+    });
+}
+
+QImage TileRenderer::renderTile(const Job& job) {
+    QImage tile(TileSize, TileSize, QImage::Format_ARGB32_Premultiplied);
+    tile.fill(job.clearColor);
+
+    QPainter painter(&tile);
+    painter.scale(job.scale, job.scale);
+    painter.translate(-job.worldRect.topLeft());
+
+    QReadLocker locker(&m_documentLock);
+    RenderList renderList;
+    renderList.compile(job.shapes, job.bounds, job.scale, m_pathCache, m_effectCache);
+    renderList.draw(painter);
+    return tile;
+}
@@ -12,14 +12,8 @@ CircleShape::CircleShape(const QPoint& topLeft, const QPoint& bottomRight) {
 
 void CircleShape::draw(QPainter& painter) const {
     painter.save();
-    QPen pen(color, penWidth);
-    painter.setPen(pen);
-    
-    if (isFilled) {
-        painter.setBrush(fillColor);
-    } else {
-        painter.setBrush(Qt::NoBrush);
-    }
+    painter.setPen(style().pen());
+    painter.setBrush(style().brush());
     
     if (rotation_ != 0.0) {
         QPoint center = m_rect.center();
@@ -32,6 +26,13 @@ void CircleShape::draw(QPainter& painter) const {
     painter.restore();
 }
 
+QPainterPath CircleShape::renderPath(qreal scale) const {
+    Q_UNUSED(scale);
+    QPainterPath path;
+    path.addEllipse(QRectF(m_rect));
+    return rotatedAbout(path, m_rect.center());
+}
+
 bool CircleShape::contains(const QPoint& pos) const {
     QRect normRect = m_rect.normalized();
     
@@ -58,7 +59,7 @@ bool CircleShape::contains(const QPoint& pos) const {
     
     qreal distance = (x*x)/(a*a) + (y*y)/(b*b);
     
-    qreal penWidthFactor = penWidth / qMin(a, b);
+    qreal penWidthFactor = style().width / qMin(a, b);
     return distance <= (1.0 + penWidthFactor) * (1.0 + penWidthFactor) && 
            distance >= (1.0 - penWidthFactor) * (1.0 - penWidthFactor);
 }
@@ -97,22 +98,17 @@ QRect CircleShape::boundingRect() const {
     transform.translate(-m_rect.center().x(), -m_rect.center().y());
 
     path = transform.map(path);
-    return path.boundingRect().adjusted(-penWidth / 2, -penWidth / 2, penWidth / 2, penWidth / 2).toRect();
+    return strokedBounds(path.boundingRect());
 }
 
 
 QJsonObject CircleShape::toJson() const {
     QJsonObject obj;
-    obj["type"] = "Circle";
     obj["x"] = m_rect.x();
     obj["y"] = m_rect.y();
     obj["width"] = m_rect.width();
     obj["height"] = m_rect.height();
-    obj["color"] = color.name();
-    obj["penWidth"] = penWidth;
-    obj["rotation"] = rotation_;
-    obj["fillColor"] = fillColor.name();
-    obj["isFilled"] = isFilled;
+    writeCommon(obj);
     return obj;
 }
 
@@ -123,11 +119,7 @@ void CircleShape::fromJson(const QJsonObject& obj) {
     int h = obj["height"].toInt();
     m_rect = QRect(x, y, w, h);
 
-    color = QColor(obj["color"].toString());
-    penWidth = obj["penWidth"].toInt();
-    rotation_ = obj["rotation"].toDouble();
-    fillColor = QColor(obj["fillColor"].toString());
-    isFilled = obj["isFilled"].toBool();
+    readCommon(obj);
 }
 
 void CircleShape::animateStep() {
@@ -0,0 +1,213 @@
+#include "../../include/Shapes/CurveShape.h"
+#include "../../include/Rendering/CurveFit.h"
+#include <QLineF>
+#include <QPainter>
+#include <QPolygonF>
+#include <QtMath>
+
+namespace {
+
+// Hit-testing flattens to within this many world units.
+constexpr qreal HitTolerance = 0.5;
+
+qreal distanceToSegment(const QPointF& point, const QLineF& segment) {
+    const QPointF direction = segment.p2() - segment.p1();
+    const qreal lengthSquared = QPointF::dotProduct(direction, direction);
+    qreal t = 0.0;
+    if (lengthSquared > 0.0) {
+        t = qBound(0.0, QPointF::dotProduct(point - segment.p1(), direction) / lengthSquared, 1.0);
+    }
+    return QLineF(point, segment.p1() + t * direction).length();
+}
+
+}
+
+CurveShape::CurveShape(const QVector<QPointF>& points)
+{
+    setPoints(points);
+}
+
+void CurveShape::setPoints(const QVector<QPointF>& points)
+{
+    m_points = points;
+    m_extent = path().boundingRect();
+}
+
+QPainterPath CurveShape::path() const
+{
+    QPainterPath path;
+    if (m_points.isEmpty()) return path;
+
+    path.moveTo(m_points.first());
+    for (qsizetype i = 1; i + 2 < m_points.size(); i += 3) {
+        path.cubicTo(m_points[i], m_points[i + 1], m_points[i + 2]);
+    }
+    return path;
+}
+
+QTransform CurveShape::rotationTransform() const
+{
+    const QPointF center = m_extent.center();
+    QTransform transform;
+    transform.translate(center.x(), center.y());
+    transform.rotate(rotation_);
+    transform.translate(-center.x(), -center.y());
+    return transform;
+}
+
+void CurveShape::draw(QPainter& painter) const
+{
+    if (segmentCount() == 0) return;
+
+    painter.save();
+    painter.setPen(style().roundPen());
+    painter.setBrush(Qt::NoBrush);
+    if (rotation_ != 0.0) {
+        painter.setTransform(rotationTransform(), true);
+    }
+    painter.drawPath(path());
+    painter.restore();
+}
+
+QPainterPath CurveShape::renderPath(qreal scale) const
+{
+    Q_UNUSED(scale);
+    if (segmentCount() == 0) return QPainterPath();
+    return rotatedAbout(path(), m_extent.center());
+}
+
+bool CurveShape::contains(const QPoint& pos) const
+{
+    if (segmentCount() == 0) return false;
+
+    QPointF point = pos;
+    if (rotation_ != 0.0) {
+        point = rotationTransform().inverted().map(point);
+    }
+
+    const qreal reach = halfPenWidth() + 5;
+    for (qsizetype i = 0; i + 3 < m_points.size(); i += 3) {
+        const QPointF* segment = m_points.constData() + i;
+        // A segment never leaves the hull of its control points.
+        const QRectF hull = QPolygonF({segment[0], segment[1], segment[2], segment[3]}).boundingRect();
+        if (!hull.adjusted(-reach, -reach, reach, reach).contains(point)) continue;
+
+        const int32_t steps = CurveFit::flattenSteps(segment, HitTolerance);
+        QPointF previous = segment[0];
+        for (int32_t k = 1; k <= steps; ++k) {
+            const QPointF next = CurveFit::pointAt(segment, qreal(k) / steps);
+            if (distanceToSegment(point, QLineF(previous, next)) <= reach) return true;
+            previous = next;
+        }
+    }
+    return false;
+}
+
+QVector<QPoint> CurveShape::flatten(qreal tolerance) const
+{
+    QVector<QPoint> points;
+    if (m_points.isEmpty()) return points;
+
+    const QTransform transform = rotation_ != 0.0 ? rotationTransform() : QTransform();
+    points.append(transform.map(m_points.first()).toPoint());
+    for (qsizetype i = 0; i + 3 < m_points.size(); i += 3) {
+        const QPointF* segment = m_points.constData() + i;
+        const int32_t steps = CurveFit::flattenSteps(segment, tolerance);
+        for (int32_t k = 1; k <= steps; ++k) {
+            const QPoint point = transform.map(CurveFit::pointAt(segment, qreal(k) / steps)).toPoint();
+            if (point != points.last()) points.append(point);
+        }
+    }
+    return points;
+}
+
+void CurveShape::moveBy(int32_t dx, int32_t dy)
+{
+    const QPointF delta(dx, dy);
+    for (QPointF& point : m_points) {
+        point += delta;
+    }
+    m_extent.translate(delta);
+}
+
+void CurveShape::resize(const QSize& size)
+{
+    if (m_points.isEmpty() || m_extent.width() <= 0 || m_extent.height() <= 0) return;
+
+    const QPointF center = m_extent.center();
+    const qreal scaleX = size.width() / m_extent.width();
+    const qreal scaleY = size.height() / m_extent.height();
+
+    QVector<QPointF> points = m_points;
+    for (QPointF& point : points) {
+        point = QPointF(center.x() + (point.x() - center.x()) * scaleX,
+                        center.y() + (point.y() - center.y()) * scaleY);
+    }
+    setPoints(points);
+}
+
+void CurveShape::rotate(double angle)
+{
+    rotation_ = angle;
+}
+
+void CurveShape::update(const QPoint& toPoint)
+{
+    QVector<QPointF> points = m_points;
+    if (!points.isEmpty()) {
+        const QLineF line(points.last(), toPoint);
+        points.append(line.pointAt(1.0 / 3.0));
+        points.append(line.pointAt(2.0 / 3.0));
+    }
+    points.append(toPoint);
+    setPoints(points);
+}
+
+QRect CurveShape::boundingRect() const
+{
+    if (segmentCount() == 0) return QRect();
+
+    QRectF extent = m_extent;
+    if (rotation_ != 0.0) {
+        extent = rotationTransform().map(path()).boundingRect();
+    }
+    return strokedBounds(extent);
+}
+
+QJsonObject CurveShape::toJson() const
+{
+    QJsonObject obj;
+    obj["points"] = writePoints(m_points);
+    writeCommon(obj);
+    return obj;
+}
+
+void CurveShape::fromJson(const QJsonObject& obj)
+{
+    QVector<QPointF> points = readPointsF(obj["points"]);
+    // Drop a trailing partial segment rather than misread the rest.
+    points.resize(points.isEmpty() ? 0 : (points.size() - 1) / 3 * 3 + 1);
+    setPoints(points);
+    readCommon(obj);
+}
+
+void CurveShape::animateStep()
+{
+    if (m_points.isEmpty()) return;
+
+    const QPointF center = m_extent.center();
+    QTransform tr;
+    m_angle += 0.1;
+    tr.translate(center.x(), center.y());
+    tr.rotate(m_angle);
+    tr.translate(-center.x(), -center.y());
+
+    QVector<QPointF> rotated = m_points;
+    for (QPointF& pt : rotated) {
+        pt = tr.map(pt);
+    }
+    setPoints(rotated);
+
+    m_hue = (m_hue + 5) % 360;
+    setStyle(style().withStroke(QColor::fromHsv(m_hue, 255, 255)));
+}
@@ -1,18 +1,52 @@
 #include "../../include/Shapes/FreehandShape.h"
+#include "../../include/Rendering/LodPolicy.h"
 #include <QPainter>
 #include <QDataStream>
+#include <QPolygonF>
 #include <algorithm>
 #include <QDebug>
+#include <QtMath>
+
+namespace {
+
+qreal distanceToSegment(const QPointF& point, const QLineF& segment) {
+    const QPointF direction = segment.p2() - segment.p1();
+    const qreal lengthSquared = QPointF::dotProduct(direction, direction);
+    qreal t = 0.0;
+    if (lengthSquared > 0.0) {
+        t = qBound(0.0, QPointF::dotProduct(point - segment.p1(), direction) / lengthSquared, 1.0);
+    }
+    return QLineF(point, segment.p1() + t * direction).length();
+}
+
+qreal distanceBetween(const QLineF& a, const QLineF& b) {
+    if (a.intersects(b) == QLineF::BoundedIntersection) return 0.0;
+    return std::min({distanceToSegment(a.p1(), b), distanceToSegment(a.p2(), b),
+                     distanceToSegment(b.p1(), a), distanceToSegment(b.p2(), a)});
+}
+
+QRectF reachOf(const QLineF& line, qreal reach) {
+    return QRectF(line.p1(), line.p2()).normalized().adjusted(-reach, -reach, reach, reach);
+}
+
+}
 
 void FreehandShape::draw(QPainter& painter) const
 {
-    if (m_points.size() < 2) return;
+    drawPoints(painter, m_points.decode());
+}
+
+void FreehandShape::drawLod(QPainter& painter, qreal scale) const
+{
+    drawPoints(painter, simplifiedPoints(scale));
+}
+
+void FreehandShape::drawPoints(QPainter& painter, const QVector<QPoint>& points) const
+{
+    if (points.size() < 2) return;
     
     painter.save();
-    QPen pen(color, penWidth);
-    pen.setCapStyle(Qt::RoundCap);
-    pen.setJoinStyle(Qt::RoundJoin);
-    painter.setPen(pen);
+    painter.setPen(style().roundPen());
     painter.setBrush(Qt::NoBrush);
     
     if (rotation_ != 0.0) {
@@ -22,58 +56,142 @@ void FreehandShape::draw(QPainter& painter) const
         painter.translate(-center);
     }
     
-    painter.drawPolyline(m_points.constData(), m_points.size());
+    painter.drawPolyline(points.constData(), points.size());
     painter.restore();
 }
 
-bool FreehandShape::contains(const QPoint& pos) const {
-    if (m_points.size() < 2) return false;
-    
-    QPointF point = pos;
-    
-    if (rotation_ != 0.0) {
-        QPoint center = m_boundingRect.center();
-        QTransform transform;
-        transform.translate(center.x(), center.y());
-        transform.rotate(-rotation_);
-        transform.translate(-center.x(), -center.y());
-        point = transform.map(point);
+QPainterPath FreehandShape::renderPath(qreal scale) const
+{
+    const QVector<QPoint> points = simplifiedPoints(scale);
+    if (points.size() < 2) return QPainterPath();
+
+    QPainterPath path;
+    path.moveTo(points.first());
+    for (qsizetype i = 1; i < points.size(); ++i) {
+        path.lineTo(points[i]);
     }
-    
-    QRect bounds = boundingRect();
-    if (!bounds.contains(point.toPoint())) {
-        return false;
+    return rotatedAbout(path, m_boundingRect.center());
+}
+
+QPen FreehandShape::renderPen() const
+{
+    return style().roundPen();
+}
+
+QVector<QPoint> FreehandShape::simplifiedPoints(qreal scale) const
+{
+    const qreal tolerance = Lod::toleranceForLevel(Lod::levelForScale(scale));
+    QVector<QPoint> points = m_points.decode();
+    if (tolerance < Lod::MinTolerance || points.size() < 3) return points;
+    return Lod::simplify(points, tolerance);
+}
+
+void FreehandShape::setPoints(const QVector<QPoint>& points)
+{
+    m_points.clear();
+    for (const QPoint& point : points) {
+        m_points.append(point);
     }
-    
-    const qreal maxDistance = penWidth/2 + 5;
-    
-    for (size_t i = 1; i < m_points.size(); ++i) {
-        QLineF line(m_points[i-1], m_points[i]);
-        QLineF normal = line.normalVector();
-        
-        qreal distance = std::abs((normal.dx()*(point.x()-line.p1().x()) + 
-                                 normal.dy()*(point.y()-line.p1().y())) / 
-                        std::sqrt(normal.dx()*normal.dx() + normal.dy()*normal.dy()));
-        
-        bool withinSegmentBounds = 
-            point.x() >= std::min(line.p1().x(), line.p2().x()) - maxDistance &&
-            point.x() <= std::max(line.p1().x(), line.p2().x()) + maxDistance &&
-            point.y() >= std::min(line.p1().y(), line.p2().y()) - maxDistance &&
-            point.y() <= std::max(line.p1().y(), line.p2().y()) + maxDistance;
-        
-        if (distance <= maxDistance && withinSegmentBounds) {
-            return true;
+    m_points.squeeze();
+
+    if (!points.isEmpty()) {
+        m_boundingRect = QRect(points.first(), QSize(1, 1));
+        for (const QPoint& point : points) {
+            m_boundingRect.setLeft(std::min(m_boundingRect.left(), point.x()));
+            m_boundingRect.setRight(std::max(m_boundingRect.right(), point.x()));
+            m_boundingRect.setTop(std::min(m_boundingRect.top(), point.y()));
+            m_boundingRect.setBottom(std::max(m_boundingRect.bottom(), point.y()));
+        }
+    }
+}
+
+bool FreehandShape::contains(const QPoint& pos) const {
+    // A zero-length sweep; only the chunks near pos are decoded.
+    return m_points.size() >= 2 && touches(QLineF(pos, pos), 5);
+}
+
+QTransform FreehandShape::rotationTransform() const
+{
+    const QPoint center = m_boundingRect.center();
+    QTransform transform;
+    transform.translate(center.x(), center.y());
+    transform.rotate(rotation_);
+    transform.translate(-center.x(), -center.y());
+    return transform;
+}
+
+bool FreehandShape::touches(const QLineF& sweep, qreal radius) const
+{
+    if (m_points.isEmpty()) return false;
+
+    // Rotation keeps distances, so the sweep can move into stroke space.
+    const QLineF local = rotation_ != 0.0 ? rotationTransform().inverted().map(sweep) : sweep;
+    const qreal reach = radius + halfPenWidth();
+    const QRectF area = reachOf(local, reach);
+
+    for (qsizetype chunk = 0; chunk < m_points.chunkCount(); ++chunk) {
+        if (!area.intersects(QRectF(m_points.chunkBounds(chunk)))) continue;
+
+        const QVector<QPoint> points = m_points.decodeChunk(chunk);
+        if (points.size() == 1 && distanceToSegment(points.first(), local) <= reach) return true;
+        for (qsizetype i = 1; i < points.size(); ++i) {
+            if (distanceBetween(QLineF(points[i - 1], points[i]), local) <= reach) return true;
         }
     }
     return false;
 }
 
-void FreehandShape::moveBy(int32_t dx, int32_t dy)
+bool FreehandShape::erase(const QLineF& sweep, qreal radius, QList<QVector<QPoint>>& pieces) const
 {
-    for (QPoint& point : m_points) {
-        point.rx() += dx;
-        point.ry() += dy;
+    if (!touches(sweep, radius)) return false;
+
+    QVector<QPoint> points = m_points.decode();
+    if (rotation_ != 0.0) {
+        const QTransform transform = rotationTransform();
+        for (QPoint& point : points) point = transform.map(point);
+    }
+
+    const qreal reach = radius + halfPenWidth();
+    const QRectF area = reachOf(sweep, reach);
+    // Long segments near the sweep are resampled so the cut lands within
+    // half an eraser radius of where the ink meets it.
+    const qreal step = qMax(1.0, radius / 2);
+
+    bool cut = false;
+    QList<QVector<QPoint>> result;
+    QVector<QPoint> piece;
+    auto visit = [&](const QPoint& point) {
+        if (distanceToSegment(point, sweep) > reach) {
+            piece.append(point);
+            return;
+        }
+        cut = true;
+        if (piece.size() >= 2) result.append(piece);
+        piece.clear();
+    };
+
+    for (qsizetype i = 0; i < points.size(); ++i) {
+        if (i > 0) {
+            const QLineF segment(points[i - 1], points[i]);
+            if (segment.length() > step && area.intersects(reachOf(segment, 1.0))) {
+                const int32_t steps = qCeil(segment.length() / step);
+                for (int32_t k = 1; k < steps; ++k) {
+                    visit(segment.pointAt(qreal(k) / steps).toPoint());
+                }
+            }
+        }
+        visit(points[i]);
     }
+    if (!cut) return false;
+
+    if (piece.size() >= 2) result.append(piece);
+    pieces = result;
+    return true;
+}
+
+void FreehandShape::moveBy(int32_t dx, int32_t dy)
+{
+    m_points.translate(dx, dy);
     m_boundingRect.translate(dx, dy);
 }
 
@@ -85,20 +203,12 @@ void FreehandShape::resize(const QSize& size) {
     qreal scaleX = size.width() / (qreal)m_boundingRect.width();
     qreal scaleY = size.height() / (qreal)m_boundingRect.height();
     
-    for (QPoint& point : m_points) {
+    QVector<QPoint> points = m_points.decode();
+    for (QPoint& point : points) {
         point.rx() = center.x() + (point.x() - center.x()) * scaleX;
         point.ry() = center.y() + (point.y() - center.y()) * scaleY;
     }
-    
-    if (!m_points.isEmpty()) {
-        m_boundingRect = QRect(m_points.first(), QSize(1, 1));
-        for (const QPoint& point : m_points) {
-            m_boundingRect.setRight(std::max(m_boundingRect.right(), point.x()));
-            m_boundingRect.setLeft(std::min(m_boundingRect.left(), point.x()));
-            m_boundingRect.setBottom(std::max(m_boundingRect.bottom(), point.y()));
-            m_boundingRect.setTop(std::min(m_boundingRect.top(), point.y()));
-        }
-    }
+    setPoints(points);
 }
 
 void FreehandShape::rotate(double angle)
@@ -126,59 +236,28 @@ QString FreehandShape::name() const {
 QRect FreehandShape::boundingRect() const {
     if (m_points.isEmpty()) return QRect();
 
-    QPainterPath path;
-    path.moveTo(m_points.first());
-    for (const QPoint& pt : m_points) {
-        path.lineTo(pt);
+    // Unrotated, the tracked extent already is the exact point bounds.
+    QRectF extent(QPointF(m_boundingRect.topLeft()), QPointF(m_boundingRect.bottomRight()));
+    if (rotation_ != 0.0) {
+        QTransform transform;
+        transform.translate(m_boundingRect.center().x(), m_boundingRect.center().y());
+        transform.rotate(rotation_);
+        transform.translate(-m_boundingRect.center().x(), -m_boundingRect.center().y());
+        extent = transform.map(QPolygonF(QPolygon(m_points.decode()))).boundingRect();
     }
-
-    QTransform transform;
-    transform.translate(m_boundingRect.center().x(), m_boundingRect.center().y());
-    transform.rotate(rotation_);
-    transform.translate(-m_boundingRect.center().x(), -m_boundingRect.center().y());
-
-    path = transform.map(path);
-    return path.boundingRect().adjusted(-penWidth / 2, -penWidth / 2, penWidth / 2, penWidth / 2).toRect();
+    return strokedBounds(extent);
 }
 
 QJsonObject FreehandShape::toJson() const {
     QJsonObject obj;
-    QJsonArray pointArray;
-    for (const QPoint& pt : m_points) {
-        QJsonObject pObj;
-        pObj["x"] = pt.x();
-        pObj["y"] = pt.y();
-        pointArray.append(pObj);
-    }
-
-    obj["points"] = pointArray;
-    obj["color"] = color.name();
-    obj["width"] = penWidth;
-    obj["rotation"] = rotation_;
+    obj["points"] = writePoints(m_points.decode());
+    writeCommon(obj);
     return obj;
 }
 
 void FreehandShape::fromJson(const QJsonObject& obj) {
-    m_points.clear();
-    QJsonArray pointArray = obj["points"].toArray();
-    for (const QJsonValue& val : pointArray) {
-        QJsonObject pObj = val.toObject();
-        m_points.append(QPoint(pObj["x"].toInt(), pObj["y"].toInt()));
-    }
-
-    color = QColor(obj["color"].toString());
-    penWidth = obj["width"].toInt();
-    rotation_ = obj["rotation"].toDouble();
-
-    if (!m_points.isEmpty()) {
-        m_boundingRect = QRect(m_points.first(), QSize(1, 1));
-        for (const QPoint& pt : m_points) {
-            m_boundingRect.setLeft(std::min(m_boundingRect.left(), pt.x()));
-            m_boundingRect.setRight(std::max(m_boundingRect.right(), pt.x()));
-            m_boundingRect.setTop(std::min(m_boundingRect.top(), pt.y()));
-            m_boundingRect.setBottom(std::max(m_boundingRect.bottom(), pt.y()));
-        }
-    }
+    setPoints(readPoints(obj["points"]));
+    readCommon(obj);
 }
 
 void FreehandShape::animateStep() {
@@ -192,11 +271,11 @@ void FreehandShape::animateStep() {
     tr.rotate(m_angle);
     tr.translate(-center.x(), -center.y());
 
-    QVector<QPoint> rotated;
-    for (const auto& pt : m_points)
-        rotated.append(tr.map(pt));
-    m_points = rotated;
+    QVector<QPoint> rotated = m_points.decode();
+    for (auto& pt : rotated)
+        pt = tr.map(pt);
+    setPoints(rotated);
 
     m_hue = (m_hue + 5) % 360;
-    color.setHsv(m_hue, 255, 255);
+    setStyle(style().withStroke(QColor::fromHsv(m_hue, 255, 255)));
 }
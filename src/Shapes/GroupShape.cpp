@@ -0,0 +1,252 @@
+#include "../../include/Shapes/GroupShape.h"
+#include "../../include/Shapes/ShapeFactory.h"
+#include "../../include/Rendering/LodPolicy.h"
+#include <QJsonArray>
+#include <QtMath>
+#include <cmath>
+
+GroupShape::GroupShape(const QList<std::shared_ptr<Shape>>& children)
+    : m_children(children)
+{
+    childrenChanged();
+}
+
+void GroupShape::draw(QPainter& painter) const
+{
+    painter.save();
+    painter.setTransform(m_transform, true);
+    for (const auto& child : m_children) {
+        child->draw(painter);
+    }
+    painter.restore();
+}
+
+void GroupShape::drawLod(QPainter& painter, qreal scale) const
+{
+    const qreal localScale = scale * m_placement.maxScale();
+
+    painter.save();
+    painter.setTransform(m_transform, true);
+    QImage layer = layerImage(localScale);
+    if (!layer.isNull()) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawImage(QRectF(layerRect()), layer);
+    } else {
+        for (const auto& child : m_children) {
+            child->drawLod(painter, localScale);
+        }
+    }
+    painter.restore();
+}
+
+QImage GroupShape::layerImage(qreal scale) const
+{
+    if (m_children.isEmpty()) return QImage();
+
+    const int32_t level = Lod::levelForScale(scale);
+    const qreal levelScale = std::ldexp(1.0, level);
+    const QRect rect = layerRect();
+    if (qMax(rect.width(), rect.height()) * levelScale > MaxLayerSize) return QImage();
+
+    std::lock_guard<std::mutex> lock(m_layerCache.mutex);
+    auto it = m_layerCache.levels.constFind(level);
+    if (it != m_layerCache.levels.constEnd()) return *it;
+
+    if (m_layerCache.levels.size() >= MaxCachedLevels) {
+        m_layerCache.levels.clear();
+    }
+
+    QImage image(qMax(1, qCeil(rect.width() * levelScale)), qMax(1, qCeil(rect.height() * levelScale)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.scale(levelScale, levelScale);
+    painter.translate(-rect.topLeft());
+    for (const auto& child : m_children) {
+        child->drawLod(painter, levelScale);
+    }
+    painter.end();
+
+    m_layerCache.levels.insert(level, image);
+    return image;
+}
+
+bool GroupShape::contains(const QPoint& pos) const
+{
+    if (!m_bounds.contains(pos)) return false;
+
+    bool invertible = false;
+    QTransform inverse = m_transform.inverted(&invertible);
+    if (!invertible) return false;
+
+    // Only children whose bounds hold the point are tested in detail.
+    QPoint local = inverse.map(QPointF(pos)).toPoint();
+    for (auto it = m_children.crbegin(); it != m_children.crend(); ++it) {
+        if ((*it)->boundingRect().contains(local) && (*it)->contains(local)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GroupShape::moveBy(int32_t dx, int32_t dy)
+{
+    m_placement.offset += QPointF(dx, dy);
+    updateTransform();
+}
+
+void GroupShape::resize(const QSize& size)
+{
+    if (m_localBounds.width() <= 0 || m_localBounds.height() <= 0) return;
+
+    m_placement.scaleX = qreal(size.width()) / m_localBounds.width();
+    m_placement.scaleY = qreal(size.height()) / m_localBounds.height();
+    updateTransform();
+}
+
+void GroupShape::rotate(double angle)
+{
+    rotation_ = angle;
+    updateTransform();
+}
+
+void GroupShape::update(const QPoint& toPoint)
+{
+    Q_UNUSED(toPoint);
+}
+
+void GroupShape::setColor(const QColor& color)
+{
+    restyleChildren([&color](Shape& child) { child.setColor(color); });
+}
+
+void GroupShape::setPenWidth(int32_t width)
+{
+    restyleChildren([width](Shape& child) { child.setPenWidth(width); });
+}
+
+void GroupShape::setFillColor(const QColor& color)
+{
+    restyleChildren([&color](Shape& child) { child.setFillColor(color); });
+}
+
+void GroupShape::setFilled(bool filled)
+{
+    restyleChildren([filled](Shape& child) { child.setFilled(filled); });
+}
+
+void GroupShape::restyleChildren(const std::function<void(Shape&)>& edit)
+{
+    // The children are shared with undo states and with the shapes they
+    // were grouped from, so the group restyles copies of them.
+    for (auto& child : m_children) {
+        std::shared_ptr<Shape> copy = ShapeFactory::clone(*child);
+        if (!copy) continue;
+        edit(*copy);
+        child = copy;
+    }
+    childrenChanged();
+}
+
+QColor GroupShape::getColor() const
+{
+    return m_children.isEmpty() ? style().stroke : m_children.first()->getColor();
+}
+
+int32_t GroupShape::getPenWidth() const
+{
+    return m_children.isEmpty() ? style().width : m_children.first()->getPenWidth();
+}
+
+QColor GroupShape::getFillColor() const
+{
+    return m_children.isEmpty() ? QColor(Qt::transparent) : m_children.first()->getFillColor();
+}
+
+bool GroupShape::isShapeFilled() const
+{
+    return !m_children.isEmpty() && m_children.first()->isShapeFilled();
+}
+
+int32_t GroupShape::complexity() const
+{
+    int32_t total = 0;
+    for (const auto& child : m_children) {
+        total += child->complexity();
+    }
+    return total;
+}
+
+QList<std::shared_ptr<Shape>> GroupShape::bakedChildren() const
+{
+    QList<std::shared_ptr<Shape>> result;
+    const bool scaled = m_placement.isScaled();
+
+    for (const auto& child : m_children) {
+        std::shared_ptr<Shape> copy = ShapeFactory::clone(*child);
+        if (!copy) continue;
+
+        QRect rect = copy->boundingRect();
+        QPoint center = m_transform.map(QPointF(rect.center())).toPoint();
+        if (scaled) {
+            copy->resize(QSize(qMax(1, qRound(rect.width() * std::abs(m_placement.scaleX))),
+                               qMax(1, qRound(rect.height() * std::abs(m_placement.scaleY)))));
+        }
+        QPoint delta = center - copy->boundingRect().center();
+        copy->moveBy(delta.x(), delta.y());
+        if (rotation_ != 0.0) {
+            copy->rotate(copy->rotation() + rotation_);
+        }
+        result.append(copy);
+    }
+    return result;
+}
+
+void GroupShape::childrenChanged()
+{
+    m_localBounds = QRect();
+    for (const auto& child : m_children) {
+        m_localBounds |= child->boundingRect();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_layerCache.mutex);
+        m_layerCache.levels.clear();
+    }
+    updateTransform();
+}
+
+void GroupShape::updateTransform()
+{
+    m_transform = m_placement.matrix(m_localBounds, rotation_);
+    m_bounds = m_transform.mapRect(QRectF(m_localBounds)).toAlignedRect();
+}
+
+QJsonObject GroupShape::toJson() const
+{
+    QJsonArray children;
+    for (const auto& child : m_children) {
+        children.append(ShapeFactory::toJson(*child));
+    }
+
+    QJsonObject obj;
+    obj["children"] = children;
+    m_placement.write(obj);
+    obj["rotation"] = rotation_;
+    return obj;
+}
+
+void GroupShape::fromJson(const QJsonObject& obj)
+{
+    m_children.clear();
+    const QJsonArray children = obj["children"].toArray();
+    m_children.reserve(children.size());
+    for (const QJsonValue& value : children) {
+        if (std::shared_ptr<Shape> child = ShapeFactory::fromJson(value.toObject())) {
+            m_children.append(child);
+        }
+    }
+
+    m_placement.read(obj);
+    rotation_ = obj["rotation"].toDouble();
+    childrenChanged();
+}
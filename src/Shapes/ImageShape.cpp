@@ -0,0 +1,183 @@
+#include "../../include/Shapes/ImageShape.h"
+#include <QPainter>
+#include <cmath>
+
+ImageShape::ImageShape(const std::shared_ptr<ImagePyramid>& image, const QRect& rect)
+    : m_path(image ? image->path() : QString()), m_image(image), m_rect(rect)
+{
+}
+
+QTransform ImageShape::rotationTransform() const
+{
+    const QPointF center = QRectF(m_rect.normalized()).center();
+    QTransform transform;
+    transform.translate(center.x(), center.y());
+    transform.rotate(rotation_);
+    transform.translate(-center.x(), -center.y());
+    return transform;
+}
+
+void ImageShape::draw(QPainter& painter) const
+{
+    // Without a level hint, the painter's own scale picks the level.
+    // Used for export, so missing detail is read rather than skipped.
+    drawPixels(painter, std::sqrt(std::abs(painter.deviceTransform().determinant())), true);
+}
+
+void ImageShape::drawLod(QPainter& painter, qreal scale) const
+{
+    drawPixels(painter, scale, false);
+}
+
+void ImageShape::drawPixels(QPainter& painter, qreal scale, bool wait) const
+{
+    const QRectF rect = m_rect.normalized();
+
+    painter.save();
+    if (rotation_ != 0.0) {
+        painter.setTransform(rotationTransform(), true);
+    }
+
+    const QSizeF size = rect.size() * scale;
+    const QImage image = m_image ? m_image->level(size) : QImage();
+    if (image.isNull()) {
+        // Still decoding, or the file is gone.
+        painter.setPen(QPen(Qt::gray, 0, Qt::DashLine));
+        painter.setBrush(QColor(0, 0, 0, 16));
+        painter.drawRect(rect);
+    } else {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawImage(rect, image);
+        // The overview of a tiled image stays underneath as the detail
+        // tiles arrive.
+        if (m_image->isTiled() && (image.width() < size.width() || image.height() < size.height())) {
+            drawDetail(painter, size, wait);
+        }
+    }
+    painter.restore();
+}
+
+void ImageShape::drawDetail(QPainter& painter, const QSizeF& size, bool wait) const
+{
+    const QRectF rect = m_rect.normalized();
+    const QRectF device(0, 0, painter.device()->width(), painter.device()->height());
+    const QRectF visible = painter.deviceTransform().inverted().mapRect(device);
+
+    const int32_t level = m_image->detailLevel(size);
+    const QRect range = detailRange(level, visible);
+    const QSize levelSize = m_image->levelSize(level);
+    const qreal sx = rect.width() / levelSize.width();
+    const qreal sy = rect.height() / levelSize.height();
+
+    for (int32_t ty = range.top(); ty <= range.bottom(); ++ty) {
+        for (int32_t tx = range.left(); tx <= range.right(); ++tx) {
+            const QImage tile = m_image->detailTile(level, QPoint(tx, ty), wait);
+            if (tile.isNull()) continue;
+
+            const QRect pixels = m_image->tileRect(level, QPoint(tx, ty));
+            painter.drawImage(QRectF(rect.left() + pixels.x() * sx, rect.top() + pixels.y() * sy,
+                                     pixels.width() * sx, pixels.height() * sy), tile);
+        }
+    }
+}
+
+QRect ImageShape::detailRange(int32_t level, const QRectF& local) const
+{
+    const QRectF rect = m_rect.normalized();
+    const QRectF visible = local & rect;
+    if (visible.isEmpty() || rect.isEmpty()) return QRect();
+
+    const QSize levelSize = m_image->levelSize(level);
+    const qreal sx = levelSize.width() / rect.width();
+    const qreal sy = levelSize.height() / rect.height();
+    return m_image->tileRange(level, QRectF((visible.left() - rect.left()) * sx, (visible.top() - rect.top()) * sy,
+                                            visible.width() * sx, visible.height() * sy));
+}
+
+QRect ImageShape::mapFromImage(const QRectF& area) const
+{
+    const QRectF rect = m_rect.normalized();
+    if (!m_image || m_image->size().isEmpty()) return rect.toAlignedRect();
+
+    const qreal sx = rect.width() / m_image->size().width();
+    const qreal sy = rect.height() / m_image->size().height();
+    QRectF world(rect.left() + area.x() * sx, rect.top() + area.y() * sy, area.width() * sx, area.height() * sy);
+    if (rotation_ != 0.0) {
+        world = rotationTransform().mapRect(world);
+    }
+    return world.toAlignedRect();
+}
+
+void ImageShape::prefetch(const QRectF& worldRect, qreal scale) const
+{
+    if (!m_image || !m_image->isTiled() || !m_image->isReady()) return;
+
+    const QSizeF size = QRectF(m_rect.normalized()).size() * scale;
+    const QImage overview = m_image->level(size);
+    if (overview.width() >= size.width() && overview.height() >= size.height()) return;
+
+    QRectF local = worldRect;
+    if (rotation_ != 0.0) {
+        local = rotationTransform().inverted().mapRect(local);
+    }
+    const int32_t level = m_image->detailLevel(size);
+    m_image->prefetch(level, detailRange(level, local));
+}
+
+bool ImageShape::contains(const QPoint& pos) const
+{
+    QPointF local = pos;
+    if (rotation_ != 0.0) {
+        local = rotationTransform().inverted().map(local);
+    }
+    return QRectF(m_rect.normalized()).contains(local);
+}
+
+void ImageShape::moveBy(int32_t dx, int32_t dy)
+{
+    m_rect.translate(dx, dy);
+}
+
+void ImageShape::resize(const QSize& size)
+{
+    m_rect.setSize(size);
+}
+
+void ImageShape::rotate(double angle)
+{
+    rotation_ = angle;
+}
+
+void ImageShape::update(const QPoint& toPoint)
+{
+    m_rect.setBottomRight(toPoint);
+}
+
+QRect ImageShape::boundingRect() const
+{
+    QRectF rect = m_rect.normalized();
+    if (rotation_ != 0.0) {
+        rect = rotationTransform().mapRect(rect);
+    }
+    return rect.toAlignedRect();
+}
+
+QJsonObject ImageShape::toJson() const
+{
+    QJsonObject obj;
+    obj["path"] = m_path;
+    obj["x"] = m_rect.x();
+    obj["y"] = m_rect.y();
+    obj["width"] = m_rect.width();
+    obj["height"] = m_rect.height();
+    obj["rotation"] = rotation_;
+    return obj;
+}
+
+void ImageShape::fromJson(const QJsonObject& obj)
+{
+    m_path = obj["path"].toString();
+    m_image = ImagePyramid::load(m_path);
+    m_rect = QRect(obj["x"].toInt(), obj["y"].toInt(), obj["width"].toInt(), obj["height"].toInt());
+    rotation_ = obj["rotation"].toDouble();
+}
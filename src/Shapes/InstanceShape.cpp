@@ -0,0 +1,178 @@
+#include "../../include/Shapes/InstanceShape.h"
+
+InstanceShape::InstanceShape(std::shared_ptr<SymbolDefinition> symbol)
+    : m_symbol(std::move(symbol))
+{
+    updateTransform();
+}
+
+void InstanceShape::draw(QPainter& painter) const
+{
+    drawSymbol(painter, 1.0);
+}
+
+void InstanceShape::drawLod(QPainter& painter, qreal scale) const
+{
+    drawSymbol(painter, scale);
+}
+
+void InstanceShape::drawSymbol(QPainter& painter, qreal scale) const
+{
+    if (!m_symbol) return;
+
+    const qreal localScale = scale * m_placement.maxScale();
+    painter.save();
+    painter.setTransform(m_transform, true);
+
+    // Shared path first, then a shared raster, then the geometry itself.
+    QPainterPath path = m_symbol->path(localScale);
+    if (!path.isEmpty()) {
+        const Shape& geometry = m_symbol->geometry();
+        if (m_styled) {
+            painter.setPen(style().pen());
+            painter.setBrush(style().brush());
+        } else {
+            painter.setPen(geometry.renderPen());
+            painter.setBrush(geometry.renderBrush());
+        }
+        painter.drawPath(path);
+    } else if (QImage raster = m_symbol->raster(localScale); !raster.isNull()) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawImage(QRectF(m_symbol->rasterRect()), raster);
+    } else {
+        m_symbol->geometry().drawLod(painter, localScale);
+    }
+    painter.restore();
+}
+
+bool InstanceShape::contains(const QPoint& pos) const
+{
+    if (!m_symbol || !m_bounds.contains(pos)) return false;
+
+    bool invertible = false;
+    QTransform inverse = m_transform.inverted(&invertible);
+    return invertible && m_symbol->geometry().contains(inverse.map(QPointF(pos)).toPoint());
+}
+
+void InstanceShape::moveBy(int32_t dx, int32_t dy)
+{
+    m_placement.offset += QPointF(dx, dy);
+    updateTransform();
+}
+
+void InstanceShape::resize(const QSize& size)
+{
+    if (!m_symbol) return;
+
+    QRect local = m_symbol->bounds();
+    if (local.width() <= 0 || local.height() <= 0) return;
+
+    m_placement.scaleX = qreal(size.width()) / local.width();
+    m_placement.scaleY = qreal(size.height()) / local.height();
+    updateTransform();
+}
+
+void InstanceShape::rotate(double angle)
+{
+    rotation_ = angle;
+    updateTransform();
+}
+
+void InstanceShape::update(const QPoint& toPoint)
+{
+    Q_UNUSED(toPoint);
+}
+
+void InstanceShape::beginOverride()
+{
+    if (m_styled || !m_symbol) return;
+
+    const Shape& geometry = m_symbol->geometry();
+    ShapeStyle own;
+    own.stroke = geometry.getColor();
+    own.width = geometry.getPenWidth();
+    own.fill = geometry.getFillColor();
+    own.filled = geometry.isShapeFilled();
+    setStyle(own);
+    m_styled = true;
+}
+
+void InstanceShape::setColor(const QColor& color)
+{
+    beginOverride();
+    setStyle(style().withStroke(color));
+}
+
+void InstanceShape::setPenWidth(int32_t width)
+{
+    beginOverride();
+    setStyle(style().withWidth(width));
+}
+
+void InstanceShape::setFillColor(const QColor& color)
+{
+    beginOverride();
+    setStyle(style().withFill(color));
+}
+
+void InstanceShape::setFilled(bool filled)
+{
+    beginOverride();
+    setStyle(style().withFilled(filled));
+}
+
+QColor InstanceShape::getColor() const
+{
+    return m_styled || !m_symbol ? style().stroke : m_symbol->geometry().getColor();
+}
+
+int32_t InstanceShape::getPenWidth() const
+{
+    return m_styled || !m_symbol ? style().width : m_symbol->geometry().getPenWidth();
+}
+
+QColor InstanceShape::getFillColor() const
+{
+    return m_styled || !m_symbol ? style().fill : m_symbol->geometry().getFillColor();
+}
+
+bool InstanceShape::isShapeFilled() const
+{
+    return m_styled || !m_symbol ? style().filled : m_symbol->geometry().isShapeFilled();
+}
+
+void InstanceShape::updateTransform()
+{
+    if (!m_symbol) {
+        m_transform = QTransform();
+        m_bounds = QRect();
+        return;
+    }
+    m_transform = m_placement.matrix(m_symbol->bounds(), rotation_);
+    m_bounds = m_transform.mapRect(QRectF(m_symbol->bounds())).toAlignedRect();
+}
+
+QJsonObject InstanceShape::toJson() const
+{
+    QJsonObject obj;
+    obj["symbol"] = m_symbol ? m_symbol->id() : QString();
+    m_placement.write(obj);
+    obj["rotation"] = rotation_;
+    if (m_styled) {
+        writeStyle(obj);
+    }
+    return obj;
+}
+
+void InstanceShape::fromJson(const QJsonObject& obj)
+{
+    m_symbol = SymbolDefinition::find(obj["symbol"].toString());
+    m_placement.read(obj);
+    rotation_ = obj["rotation"].toDouble();
+
+    m_styled = obj.contains("style") || obj.contains("color");
+    if (m_styled) {
+        readStyle(obj);
+    }
+    updateTransform();
+}
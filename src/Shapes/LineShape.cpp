@@ -9,9 +9,7 @@ LineShape::LineShape(QPoint from, QPoint to)
 
 void LineShape::draw(QPainter& painter) const {
     painter.save();
-    QPen pen(color, penWidth);
-    pen.setCapStyle(Qt::RoundCap);
-    painter.setPen(pen);
+    painter.setPen(style().roundPen());
     
     if (rotation_ != 0.0) {
         QPoint center = (p1 + p2) / 2;
@@ -24,7 +22,20 @@ void LineShape::draw(QPainter& painter) const {
     painter.restore();
 }
 
+QPainterPath LineShape::renderPath(qreal scale) const {
+    Q_UNUSED(scale);
+    QPainterPath path;
+    path.moveTo(p1);
+    path.lineTo(p2);
+    return rotatedAbout(path, (p1 + p2) / 2);
+}
+
+QPen LineShape::renderPen() const {
+    return style().roundPen();
+}
+
 bool LineShape::contains(const QPoint& pos) const {
+    const int32_t penWidth = style().width;
     if (rotation_ == 0.0) {
         QLineF line(p1, p2);
         QLineF normal = line.normalVector();
@@ -109,7 +120,7 @@ QRect LineShape::boundingRect() const {
     transform.translate(-center.x(), -center.y());
 
     path = transform.map(path);
-    return path.boundingRect().adjusted(-penWidth / 2, -penWidth / 2, penWidth / 2, penWidth / 2).toRect();
+    return strokedBounds(path.boundingRect());
 }
 
 QJsonObject LineShape::toJson() const {
@@ -118,18 +129,14 @@ QJsonObject LineShape::toJson() const {
     obj["p1y"] = p1.y();
     obj["p2x"] = p2.x();
     obj["p2y"] = p2.y();
-    obj["color"] = color.name();
-    obj["width"] = penWidth;
-    obj["rotation"] = rotation_;
+    writeCommon(obj);
     return obj;
 }
 
 void LineShape::fromJson(const QJsonObject& obj) {
     p1 = QPoint(obj["p1x"].toInt(), obj["p1y"].toInt());
     p2 = QPoint(obj["p2x"].toInt(), obj["p2y"].toInt());
-    color = QColor(obj["color"].toString());
-    penWidth = obj["width"].toInt();
-    rotation_ = obj["rotation"].toDouble();
+    readCommon(obj);
 }
 
 void LineShape::animateStep() {
@@ -0,0 +1,35 @@
+#include "../../include/Shapes/LocalTransform.h"
+#include <QtMath>
+#include <cmath>
+
+QTransform LocalTransform::matrix(const QRect& localBounds, qreal rotation) const {
+    QPointF origin = localBounds.topLeft();
+    QPointF center = origin + QPointF(localBounds.width() * scaleX, localBounds.height() * scaleY) / 2;
+
+    QTransform transform;
+    transform.translate(offset.x(), offset.y());
+    transform.translate(center.x(), center.y());
+    transform.rotate(rotation);
+    transform.translate(-center.x(), -center.y());
+    transform.translate(origin.x(), origin.y());
+    transform.scale(scaleX, scaleY);
+    transform.translate(-origin.x(), -origin.y());
+    return transform;
+}
+
+qreal LocalTransform::maxScale() const {
+    return qMax(std::abs(scaleX), std::abs(scaleY));
+}
+
+void LocalTransform::write(QJsonObject& obj) const {
+    obj["offsetX"] = offset.x();
+    obj["offsetY"] = offset.y();
+    obj["scaleX"] = scaleX;
+    obj["scaleY"] = scaleY;
+}
+
+void LocalTransform::read(const QJsonObject& obj) {
+    offset = QPointF(obj["offsetX"].toDouble(), obj["offsetY"].toDouble());
+    scaleX = obj["scaleX"].toDouble(1.0);
+    scaleY = obj["scaleY"].toDouble(1.0);
+}
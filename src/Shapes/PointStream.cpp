@@ -0,0 +1,214 @@
+#include "../../include/Shapes/PointStream.h"
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define POINTSTREAM_SSE2
+#endif
+
+namespace {
+
+template <typename T>
+bool fits(int32_t value) {
+    return value >= std::numeric_limits<T>::min() && value <= std::numeric_limits<T>::max();
+}
+
+void extend(QRect& rect, const QPoint& point) {
+    if (point.x() < rect.left()) rect.setLeft(point.x());
+    if (point.x() > rect.right()) rect.setRight(point.x());
+    if (point.y() < rect.top()) rect.setTop(point.y());
+    if (point.y() > rect.bottom()) rect.setBottom(point.y());
+}
+
+template <typename T>
+void appendDelta(std::pmr::vector<char>& bytes, int32_t dx, int32_t dy) {
+    const T delta[2] = {T(dx), T(dy)};
+    const char* data = reinterpret_cast<const char*>(delta);
+    bytes.insert(bytes.end(), data, data + sizeof(delta));
+}
+
+// Decodes count deltas of type T, continuing from (x, y).
+template <typename T>
+void decodeScalar(const char* data, qsizetype count, QPoint* out, int32_t x, int32_t y) {
+    for (qsizetype i = 0; i < count; ++i) {
+        T delta[2];
+        std::memcpy(delta, data + i * sizeof(delta), sizeof(delta));
+        x += delta[0];
+        y += delta[1];
+        out[i] = QPoint(x, y);
+    }
+}
+
+#ifdef POINTSTREAM_SSE2
+static_assert(sizeof(QPoint) == 2 * sizeof(int32_t), "QPoint is stored as two ints");
+
+// Two points per step: deltas (dx0, dy0, dx1, dy1) as 32-bit lanes get
+// the first pair added onto the second, then the running position.
+inline void prefixStep(__m128i deltas, __m128i& position, QPoint* out) {
+    deltas = _mm_add_epi32(deltas, _mm_slli_si128(deltas, 8));
+    const __m128i points = _mm_add_epi32(deltas, position);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), points);
+    position = _mm_shuffle_epi32(points, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+inline int32_t laneX(__m128i position) { return _mm_cvtsi128_si32(position); }
+inline int32_t laneY(__m128i position) { return _mm_cvtsi128_si32(_mm_srli_si128(position, 4)); }
+
+template <typename T>
+void decodeDeltas(const char* data, qsizetype count, QPoint* out, int32_t x, int32_t y) {
+    __m128i position = _mm_setr_epi32(x, y, x, y);
+    qsizetype i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i deltas;
+        if constexpr (sizeof(T) == 1) {
+            int32_t packed;
+            std::memcpy(&packed, data + i * 2, sizeof(packed));
+            const __m128i bytes = _mm_cvtsi32_si128(packed);
+            const __m128i words = _mm_unpacklo_epi8(bytes, bytes);
+            deltas = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 24);
+        } else {
+            const __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i * 4));
+            deltas = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+        }
+        prefixStep(deltas, position, out + i);
+    }
+    if (i < count) {
+        decodeScalar<T>(data + i * 2 * sizeof(T), count - i, out + i, laneX(position), laneY(position));
+    }
+}
+#else
+template <typename T>
+void decodeDeltas(const char* data, qsizetype count, QPoint* out, int32_t x, int32_t y) {
+    decodeScalar<T>(data, count, out, x, y);
+}
+#endif
+
+}
+
+PointStream::PointStream(const PointStream& other)
+    : m_chunks(other.m_chunks.begin(), other.m_chunks.end(), m_pool.get()),
+      m_deltas(other.m_deltas.begin(), other.m_deltas.end(), m_pool.get()),
+      m_last(other.m_last),
+      m_size(other.m_size)
+{
+}
+
+PointStream& PointStream::operator=(const PointStream& other)
+{
+    m_chunks.assign(other.m_chunks.begin(), other.m_chunks.end());
+    m_deltas.assign(other.m_deltas.begin(), other.m_deltas.end());
+    m_last = other.m_last;
+    m_size = other.m_size;
+    return *this;
+}
+
+void PointStream::clear()
+{
+    m_chunks.clear();
+    m_deltas.clear();
+    m_last = QPoint();
+    m_size = 0;
+}
+
+void PointStream::append(const QPoint& point)
+{
+    const int32_t dx = point.x() - m_last.x();
+    const int32_t dy = point.y() - m_last.y();
+    const QPoint previous = m_last;
+    m_last = point;
+    ++m_size;
+
+    if (m_chunks.empty() || m_chunks.back().count >= ChunkSize || !fits<qint16>(dx) || !fits<qint16>(dy)) {
+        Chunk chunk;
+        chunk.origin = point;
+        chunk.offset = int32_t(m_deltas.size());
+        chunk.bounds = QRect(point, QSize(1, 1));
+        if (!m_chunks.empty()) extend(chunk.bounds, previous);
+        m_chunks.push_back(chunk);
+        return;
+    }
+
+    if (!m_chunks.back().wide && !(fits<qint8>(dx) && fits<qint8>(dy))) {
+        widenLastChunk();
+    }
+    Chunk& chunk = m_chunks.back();
+    if (chunk.wide) {
+        appendDelta<qint16>(m_deltas, dx, dy);
+    } else {
+        appendDelta<qint8>(m_deltas, dx, dy);
+    }
+    ++chunk.count;
+    extend(chunk.bounds, point);
+}
+
+void PointStream::widenLastChunk()
+{
+    // The last chunk's deltas always sit at the end of the buffer.
+    Chunk& chunk = m_chunks.back();
+    const std::vector<char> narrow(m_deltas.begin() + chunk.offset, m_deltas.end());
+    m_deltas.resize(chunk.offset);
+    for (size_t i = 0; i + 1 < narrow.size(); i += 2) {
+        appendDelta<qint16>(m_deltas, qint8(narrow[i]), qint8(narrow[i + 1]));
+    }
+    chunk.wide = true;
+}
+
+void PointStream::squeeze()
+{
+    m_chunks.shrink_to_fit();
+    m_deltas.shrink_to_fit();
+}
+
+void PointStream::translate(int32_t dx, int32_t dy)
+{
+    for (Chunk& chunk : m_chunks) {
+        chunk.origin += QPoint(dx, dy);
+        chunk.bounds.translate(dx, dy);
+    }
+    m_last += QPoint(dx, dy);
+}
+
+QVector<QPoint> PointStream::decode() const
+{
+    QVector<QPoint> points;
+    decode(points);
+    return points;
+}
+
+void PointStream::decode(QVector<QPoint>& points) const
+{
+    points.resize(m_size);
+    QPoint* out = points.data();
+    for (const Chunk& chunk : m_chunks) {
+        decodeChunk(chunk, out);
+        out += chunk.count;
+    }
+}
+
+QVector<QPoint> PointStream::decodeChunk(qsizetype index) const
+{
+    const Chunk& chunk = m_chunks[index];
+    const qsizetype lead = index > 0 ? 1 : 0;
+    QVector<QPoint> points(lead + chunk.count);
+    if (lead) {
+        const Chunk& previous = m_chunks[index - 1];
+        QPoint before[ChunkSize];
+        decodeChunk(previous, before);
+        points[0] = before[previous.count - 1];
+    }
+    decodeChunk(chunk, points.data() + lead);
+    return points;
+}
+
+void PointStream::decodeChunk(const Chunk& chunk, QPoint* out) const
+{
+    *out++ = chunk.origin;
+    const qsizetype deltas = chunk.count - 1;
+    const char* data = m_deltas.data() + chunk.offset;
+    if (chunk.wide) {
+        decodeDeltas<qint16>(data, deltas, out, chunk.origin.x(), chunk.origin.y());
+    } else {
+        decodeDeltas<qint8>(data, deltas, out, chunk.origin.x(), chunk.origin.y());
+    }
+}
@@ -6,27 +6,40 @@ PolygonShape::PolygonShape(const QVector<QPoint>& points) {
     m_polygon = QPolygon(points);
 }
 
+PolygonShape::PolygonShape(const QVector<QPoint>& outline, const QList<QPolygon>& holes)
+    : m_polygon(outline), m_holes(holes) {
+}
+
+QPainterPath PolygonShape::path() const {
+    QPainterPath path;
+    path.setFillRule(Qt::OddEvenFill);
+    path.addPolygon(m_polygon);
+    for (const QPolygon& hole : m_holes) {
+        path.addPolygon(hole);
+    }
+    return path;
+}
+
 void PolygonShape::draw(QPainter& painter) const {
     painter.save();
-    QPen pen(color, penWidth);
-    painter.setPen(pen);
-    
-    if (isFilled) {
-        painter.setBrush(fillColor);
-    } else {
-        painter.setBrush(Qt::NoBrush);
-    }
+    painter.setPen(style().pen());
+    painter.setBrush(style().brush());
     
     if (rotation_ != 0.0) {
-        QPoint center = boundingRect().center();
+        QPoint center = m_polygon.boundingRect().center();
         painter.translate(center);
         painter.rotate(rotation_);
         painter.translate(-center);
     }
     
-    painter.drawPolygon(m_polygon);
+    if (m_holes.isEmpty()) {
+        painter.drawPolygon(m_polygon);
+    } else {
+        painter.drawPath(path());
+    }
 
-    if (m_polygon.isDetached()) {
+    // Vertex markers only while the polygon is still being drawn.
+    if (m_polygon.size() < 3 || m_polygon.first() != m_polygon.last()) {
         painter.setBrush(Qt::red);
         for (const QPoint& p : m_polygon) {
             painter.drawEllipse(p, 3, 3);
@@ -42,21 +55,18 @@ void PolygonShape::draw(QPainter& painter) const {
     painter.restore();
 }
 
+QPainterPath PolygonShape::renderPath(qreal scale) const {
+    Q_UNUSED(scale);
+    if (m_polygon.size() < 3 || m_polygon.first() != m_polygon.last()) return QPainterPath();
+    return snapPath();
+}
+
 bool PolygonShape::contains(const QPoint& pos) const {
-    QPainterPath path;
-    path.addPolygon(m_polygon);
-    
-    if (rotation_ != 0.0) {
-        QTransform transform;
-        QPoint center = boundingRect().center();
-        transform.translate(center.x(), center.y());
-        transform.rotate(-rotation_);
-        transform.translate(-center.x(), -center.y());
-        path = transform.map(path);
-    }
+    // The same rotation draw() applies.
+    const QPainterPath path = snapPath();
     
     QPainterPathStroker stroker;
-    stroker.setWidth(penWidth);
+    stroker.setWidth(style().width);
     QPainterPath outline = stroker.createStroke(path);
     
     return outline.contains(pos) || path.contains(pos);
@@ -64,6 +74,9 @@ bool PolygonShape::contains(const QPoint& pos) const {
 
 void PolygonShape::moveBy(int32_t dx, int32_t dy) {
     m_polygon.translate(dx, dy);
+    for (QPolygon& hole : m_holes) {
+        hole.translate(dx, dy);
+    }
 }
 
 void PolygonShape::resize(const QSize& size) {
@@ -75,11 +88,18 @@ void PolygonShape::resize(const QSize& size) {
     qreal scaleX = static_cast<qreal>(size.width()) / oldRect.width();
     qreal scaleY = static_cast<qreal>(size.height()) / oldRect.height();
     
-    for (int i = 0; i < m_polygon.size(); ++i) {
-        QPoint p = m_polygon[i];
-        p.setX(oldRect.left() + (p.x() - oldRect.left()) * scaleX);
-        p.setY(oldRect.top() + (p.y() - oldRect.top()) * scaleY);
-        m_polygon[i] = p;
+    // Holes scale with the outline's bounds so they stay where they were.
+    auto scale = [&](QPolygon& polygon) {
+        for (int i = 0; i < polygon.size(); ++i) {
+            QPoint p = polygon[i];
+            p.setX(oldRect.left() + (p.x() - oldRect.left()) * scaleX);
+            p.setY(oldRect.top() + (p.y() - oldRect.top()) * scaleY);
+            polygon[i] = p;
+        }
+    };
+    scale(m_polygon);
+    for (QPolygon& hole : m_holes) {
+        scale(hole);
     }
 }
 
@@ -95,20 +115,23 @@ void PolygonShape::update(const QPoint& toPoint) {
     }
 }
 
+int32_t PolygonShape::complexity() const {
+    int32_t count = m_polygon.size();
+    for (const QPolygon& hole : m_holes) {
+        count += hole.size();
+    }
+    return count;
+}
+
+QPainterPath PolygonShape::snapPath() const {
+    return rotatedAbout(path(), m_polygon.boundingRect().center());
+}
+
 QRect PolygonShape::boundingRect() const {
+    // Holes lie inside the outline, so they never widen the bounds.
     QPainterPath path;
     path.addPolygon(m_polygon);
-    
-    if (rotation_ != 0.0) {
-        QTransform transform;
-        QPoint center = m_polygon.boundingRect().center();
-        transform.translate(center.x(), center.y());
-        transform.rotate(rotation_);
-        transform.translate(-center.x(), -center.y());
-        path = transform.map(path);
-    }
-    
-    return path.boundingRect().adjusted(-penWidth/2, -penWidth/2, penWidth/2, penWidth/2).toRect();
+    return strokedBounds(rotatedAbout(path, m_polygon.boundingRect().center()).boundingRect());
 }
 
 void PolygonShape::addPoint(const QPoint& point) {
@@ -128,36 +151,23 @@ void PolygonShape::finishShape() {
 
 QJsonObject PolygonShape::toJson() const {
     QJsonObject obj;
-    obj["type"] = "Polygon";
-    
-    QJsonArray pointsArray;
-    for (const QPoint& point : m_polygon) {
-        QJsonObject pointObj;
-        pointObj["x"] = point.x();
-        pointObj["y"] = point.y();
-        pointsArray.append(pointObj);
+    obj["points"] = writePoints(m_polygon);
+    if (!m_holes.isEmpty()) {
+        QJsonArray holesArray;
+        for (const QPolygon& hole : m_holes) {
+            holesArray.append(writePoints(hole));
+        }
+        obj["holes"] = holesArray;
     }
-    obj["points"] = pointsArray;
-    obj["color"] = color.name();
-    obj["penWidth"] = penWidth;
-    obj["rotation"] = rotation_;
-    obj["fillColor"] = fillColor.name();
-    obj["isFilled"] = isFilled;
-    
+    writeCommon(obj);
     return obj;
 }
 
 void PolygonShape::fromJson(const QJsonObject& obj) {
-    m_polygon.clear();
-    QJsonArray pointsArray = obj["points"].toArray();
-    for (const QJsonValue& val : pointsArray) {
-        QJsonObject pointObj = val.toObject();
-        m_polygon << QPoint(pointObj["x"].toInt(), pointObj["y"].toInt());
+    m_polygon = QPolygon(readPoints(obj["points"]));
+    m_holes.clear();
+    for (const QJsonValue& hole : obj["holes"].toArray()) {
+        m_holes.append(QPolygon(readPoints(hole)));
     }
-    
-    color = QColor(obj["color"].toString());
-    penWidth = obj["penWidth"].toInt();
-    rotation_ = obj["rotation"].toDouble();
-    fillColor = QColor(obj["fillColor"].toString());
-    isFilled = obj["isFilled"].toBool();
+    readCommon(obj);
 }
\ No newline at end of file
@@ -10,14 +10,8 @@ RectangleShape::RectangleShape(const QPoint& topLeft, const QPoint& bottomRight)
 void RectangleShape::draw(QPainter& painter) const
 {
     painter.save();
-    QPen pen(color, penWidth);
-    painter.setPen(pen);
-    
-    if (isFilled) {
-        painter.setBrush(fillColor);
-    } else {
-        painter.setBrush(Qt::NoBrush);
-    }
+    painter.setPen(style().pen());
+    painter.setBrush(style().brush());
     
     if (rotation_ != 0.0) {
         QPoint center = (m_topLeft + m_bottomRight) / 2;
@@ -30,13 +24,21 @@ void RectangleShape::draw(QPainter& painter) const
     painter.restore();
 }
 
+QPainterPath RectangleShape::renderPath(qreal scale) const {
+    Q_UNUSED(scale);
+    QPainterPath path;
+    path.addRect(QRectF(QRect(m_topLeft, m_bottomRight)));
+    return rotatedAbout(path, (m_topLeft + m_bottomRight) / 2);
+}
+
 bool RectangleShape::contains(const QPoint& pos) const {
     QRect rect(m_topLeft, m_bottomRight);
     rect = rect.normalized();
     
     if (rotation_ == 0.0) {
-        QRect outer = rect.adjusted(-penWidth/2, -penWidth/2, penWidth/2, penWidth/2);
-        QRect inner = rect.adjusted(penWidth/2, penWidth/2, -penWidth/2, -penWidth/2);
+        const int32_t half = halfPenWidth();
+        QRect outer = rect.adjusted(-half, -half, half, half);
+        QRect inner = rect.adjusted(half, half, -half, -half);
         return outer.contains(pos) && !inner.contains(pos);
     } else {
         QPoint center = rect.center();
@@ -48,8 +50,9 @@ bool RectangleShape::contains(const QPoint& pos) const {
         transform.translate(-center.x(), -center.y());
         rotatedPos = transform.map(rotatedPos);
         
-        QRect outer = rect.adjusted(-penWidth/2, -penWidth/2, penWidth/2, penWidth/2);
-        QRect inner = rect.adjusted(penWidth/2, penWidth/2, -penWidth/2, -penWidth/2);
+        const int32_t half = halfPenWidth();
+        QRect outer = rect.adjusted(-half, -half, half, half);
+        QRect inner = rect.adjusted(half, half, -half, -half);
         return outer.contains(rotatedPos.toPoint()) && !inner.contains(rotatedPos.toPoint());
     }
 }
@@ -113,7 +116,7 @@ QRect RectangleShape::boundingRect() const {
     transform.translate(-rect.center().x(), -rect.center().y());
 
     path = transform.map(path);
-    return path.boundingRect().adjusted(-penWidth / 2, -penWidth / 2, penWidth / 2, penWidth / 2).toRect();
+    return strokedBounds(path.boundingRect());
 }
    
 
@@ -123,22 +126,14 @@ QJsonObject RectangleShape::toJson() const {
     obj["y1"] = m_topLeft.y();
     obj["x2"] = m_bottomRight.x();
     obj["y2"] = m_bottomRight.y();
-    obj["color"] = color.name();
-    obj["width"] = penWidth;
-    obj["rotation"] = rotation_;
-    obj["fillColor"] = fillColor.name();
-    obj["isFilled"] = isFilled;
+    writeCommon(obj);
     return obj;
 }
 
 void RectangleShape::fromJson(const QJsonObject& obj) {
     m_topLeft = QPoint(obj["x1"].toInt(), obj["y1"].toInt());
     m_bottomRight = QPoint(obj["x2"].toInt(), obj["y2"].toInt());
-    color = QColor(obj["color"].toString());
-    penWidth = obj["width"].toInt();
-    rotation_ = obj["rotation"].toDouble();
-    fillColor = QColor(obj["fillColor"].toString());
-    isFilled = obj["isFilled"].toBool();
+    readCommon(obj);
 }
 
 void RectangleShape::animateStep() {
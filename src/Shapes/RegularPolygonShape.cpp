@@ -1,22 +1,91 @@
 #include "../../include/Shapes/RegularPolygonShape.h"
 #include <QPainter>
 #include <QtMath>
+#include <array>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using UnitVertex = RegularPolygonShape::UnitVertex;
+
+constexpr double Pi = 3.14159265358979323846;
+constexpr int32_t MinTableSides = 3;
+constexpr int32_t MaxTableSides = 12;
+
+// Taylor series, accurate to about 1e-13 for |x| <= pi, far below a
+// pixel at any radius the canvas draws.
+constexpr double tableSin(double x) {
+    double term = x;
+    double sum = x;
+    for (int32_t k = 1; k <= 12; ++k) {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double tableCos(double x) {
+    double term = 1.0;
+    double sum = 1.0;
+    for (int32_t k = 1; k <= 12; ++k) {
+        term *= -x * x / ((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Index of the first vertex of the n-sided polygon in the flat table.
+constexpr int32_t tableOffset(int32_t sides) {
+    return (sides - 1) * sides / 2 - (MinTableSides - 1) * MinTableSides / 2;
+}
+
+constexpr auto makeUnitTable() {
+    std::array<UnitVertex, tableOffset(MaxTableSides + 1)> table{};
+    for (int32_t sides = MinTableSides; sides <= MaxTableSides; ++sides) {
+        for (int32_t i = 0; i < sides; ++i) {
+            double angle = 2 * Pi * i / sides;
+            if (angle > Pi) angle -= 2 * Pi;
+            table[tableOffset(sides) + i] = {tableCos(angle), tableSin(angle)};
+        }
+    }
+    return table;
+}
+
+constexpr auto UnitTable = makeUnitTable();
+
+}
+
+const RegularPolygonShape::UnitVertex* RegularPolygonShape::unitPolygon(int32_t sides) {
+    if (sides >= MinTableSides && sides <= MaxTableSides) {
+        return &UnitTable[tableOffset(sides)];
+    }
+
+    // Map nodes never move, so handed-out pointers stay valid.
+    static std::mutex mutex;
+    static std::unordered_map<int32_t, std::vector<UnitVertex>> polygons;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<UnitVertex>& unit = polygons[sides];
+    if (unit.empty()) {
+        for (int32_t i = 0; i < sides; ++i) {
+            double angle = 2 * Pi * i / sides;
+            unit.push_back({std::cos(angle), std::sin(angle)});
+        }
+    }
+    return unit.data();
+}
 
 RegularPolygonShape::RegularPolygonShape(const QPoint& center, int radius, int sides) 
-    : m_center(center), m_radius(radius), m_sides(sides) {
+    : m_center(center), m_radius(radius), m_sides(qMax(3, sides)), m_unit(unitPolygon(m_sides)) {
     updatePolygon();
 }
 
 void RegularPolygonShape::draw(QPainter& painter) const {
     painter.save();
-    QPen pen(color, penWidth);
-    painter.setPen(pen);
-    
-    if (isFilled) {
-        painter.setBrush(fillColor);
-    } else {
-        painter.setBrush(Qt::NoBrush);
-    }
+    painter.setPen(style().pen());
+    painter.setBrush(style().brush());
     
     if (rotation_ != 0.0) {
         painter.translate(m_center);
@@ -28,28 +97,31 @@ void RegularPolygonShape::draw(QPainter& painter) const {
     painter.restore();
 }
 
+QPainterPath RegularPolygonShape::renderPath(qreal scale) const {
+    Q_UNUSED(scale);
+    QPainterPath path;
+    path.addPolygon(m_polygon);
+    path.closeSubpath();
+    return rotatedAbout(path, m_center);
+}
+
 bool RegularPolygonShape::contains(const QPoint& pos) const {
     QPainterPath path;
     path.addPolygon(m_polygon);
-    
-    if (rotation_ != 0.0) {
-        QTransform transform;
-        transform.translate(m_center.x(), m_center.y());
-        transform.rotate(-rotation_);
-        transform.translate(-m_center.x(), -m_center.y());
-        path = transform.map(path);
-    }
+    // The same rotation draw() and boundingRect() apply.
+    path = rotatedAbout(path, m_center);
     
     QPainterPathStroker stroker;
-    stroker.setWidth(penWidth);
+    stroker.setWidth(style().width);
     QPainterPath outline = stroker.createStroke(path);
     
     return outline.contains(pos) || path.contains(pos);
 }
 
 void RegularPolygonShape::moveBy(int32_t dx, int32_t dy) {
+    // Vertices are offsets from the centre, so they simply shift along.
     m_center += QPoint(dx, dy);
-    updatePolygon();
+    m_polygon.translate(dx, dy);
 }
 
 void RegularPolygonShape::resize(const QSize& size) {
@@ -69,47 +141,29 @@ void RegularPolygonShape::update(const QPoint& toPoint) {
 QRect RegularPolygonShape::boundingRect() const {
     QPainterPath path;
     path.addPolygon(m_polygon);
-    
-    if (rotation_ != 0.0) {
-        QTransform transform;
-        transform.translate(m_center.x(), m_center.y());
-        transform.rotate(-rotation_);
-        transform.translate(-m_center.x(), -m_center.y());
-        path = transform.map(path);
-    }
-    
-    return path.boundingRect().adjusted(-penWidth/2, -penWidth/2, penWidth/2, penWidth/2).toRect();
+    return strokedBounds(rotatedAbout(path, m_center).boundingRect());
 }
 
 void RegularPolygonShape::setSides(int32_t sides) {
     m_sides = qMax(3, sides);
+    m_unit = unitPolygon(m_sides);
     updatePolygon();
 }
 
 void RegularPolygonShape::updatePolygon() {
-    m_polygon.clear();
-    double angleStep = 2 * M_PI / m_sides;
-    
-    for (int i = 0; i < m_sides; ++i) {
-        double angle = i * angleStep;
-        int x = m_center.x() + m_radius * cos(angle);
-        int y = m_center.y() + m_radius * sin(angle);
-        m_polygon << QPoint(x, y);
+    m_polygon.resize(m_sides);
+    for (int32_t i = 0; i < m_sides; ++i) {
+        m_polygon[i] = m_center + QPoint(qRound(m_radius * m_unit[i].x), qRound(m_radius * m_unit[i].y));
     }
 }
 
 QJsonObject RegularPolygonShape::toJson() const {
     QJsonObject obj;
-    obj["type"] = "RegularPolygon";
     obj["centerX"] = m_center.x();
     obj["centerY"] = m_center.y();
     obj["radius"] = m_radius;
     obj["sides"] = m_sides;
-    obj["color"] = color.name();
-    obj["penWidth"] = penWidth;
-    obj["rotation"] = rotation_;
-    obj["fillColor"] = fillColor.name();
-    obj["isFilled"] = isFilled;
+    writeCommon(obj);
     
     return obj;
 }
@@ -117,13 +171,10 @@ QJsonObject RegularPolygonShape::toJson() const {
 void RegularPolygonShape::fromJson(const QJsonObject& obj) {
     m_center = QPoint(obj["centerX"].toInt(), obj["centerY"].toInt());
     m_radius = obj["radius"].toInt();
-    m_sides = obj["sides"].toInt();
+    m_sides = qMax(3, obj["sides"].toInt());
+    m_unit = unitPolygon(m_sides);
     
-    color = QColor(obj["color"].toString());
-    penWidth = obj["penWidth"].toInt();
-    rotation_ = obj["rotation"].toDouble();
-    fillColor = QColor(obj["fillColor"].toString());
-    isFilled = obj["isFilled"].toBool();
+    readCommon(obj);
     
     updatePolygon();
 }
\ No newline at end of file
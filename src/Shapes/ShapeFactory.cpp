@@ -0,0 +1,182 @@
+#include "../../include/Shapes/ShapeFactory.h"
+#include "../../include/Shapes/LineShape.h"
+#include "../../include/Shapes/CircleShape.h"
+#include "../../include/Shapes/RectangleShape.h"
+#include "../../include/Shapes/FreehandShape.h"
+#include "../../include/Shapes/CurveShape.h"
+#include "../../include/Shapes/PolygonShape.h"
+#include "../../include/Shapes/RegularPolygonShape.h"
+#include "../../include/Shapes/TextShape.h"
+#include "../../include/Shapes/ImageShape.h"
+#include "../../include/Shapes/GroupShape.h"
+#include "../../include/Shapes/InstanceShape.h"
+#include "../../include/ToolBar.h"
+#include <QHash>
+#include <mutex>
+#include <tuple>
+#include <typeindex>
+#include <unordered_map>
+
+namespace ShapeFactory {
+
+namespace {
+
+template <typename T>
+std::shared_ptr<Shape> createDefault() {
+    return make<T>();
+}
+
+// Shapes dragged out from their first corner.
+template <typename T>
+std::shared_ptr<Shape> beginCorner(const QPoint& start) {
+    return make<T>(start, start);
+}
+
+// Shapes built up point by point.
+template <typename T>
+std::shared_ptr<Shape> beginPoints(const QPoint& start) {
+    auto shape = make<T>();
+    shape->update(start);
+    return shape;
+}
+
+std::shared_ptr<Shape> beginRegularPolygon(const QPoint& start) {
+    return make<RegularPolygonShape>(start, 10, 5);
+}
+
+template <typename T>
+std::shared_ptr<Shape> copyOf(const Shape& shape) {
+    std::shared_ptr<Shape> copy = make<T>(static_cast<const T&>(shape));
+    copy->markChanged();
+    return copy;
+}
+
+// What a shape type adds to its class: the saved tag and its tool.
+template <typename T>
+struct Type {
+    const char* name;
+    int32_t tool = -1;
+    std::shared_ptr<Shape> (*begin)(const QPoint& start) = nullptr;
+};
+
+// Every shape type, once. The registry below, and with it loading, saving,
+// cloning and the drawing tools, is derived from this list.
+constexpr auto shapeTypes = std::make_tuple(
+    Type<LineShape>{"Line", ToolBar::LineTool, &beginCorner<LineShape>},
+    Type<CircleShape>{"Circle", ToolBar::CircleTool, &beginCorner<CircleShape>},
+    Type<RectangleShape>{"Rectangle", ToolBar::RectangleTool, &beginCorner<RectangleShape>},
+    Type<FreehandShape>{"Freehand", ToolBar::FreehandTool, &beginPoints<FreehandShape>},
+    // Fitted from finished freehand strokes.
+    Type<CurveShape>{"Curve"},
+    Type<PolygonShape>{"Polygon", ToolBar::PolygonTool, &beginPoints<PolygonShape>},
+    Type<RegularPolygonShape>{"RegularPolygon", ToolBar::RegularPolygonTool, &beginRegularPolygon},
+    // Text is typed into a dialog, not dragged out.
+    Type<TextShape>{"Text"},
+    Type<ImageShape>{"Image"},
+    Type<GroupShape>{"Group"},
+    Type<InstanceShape>{"Instance"}
+);
+
+struct Registry {
+    QList<TypeInfo> types;
+    QHash<QString, qsizetype> byName;
+    std::unordered_map<std::type_index, qsizetype> byType;
+    QHash<int32_t, qsizetype> byTool;
+
+    Registry() {
+        std::apply([this](const auto&... type) { (add(type), ...); }, shapeTypes);
+    }
+
+    template <typename T>
+    void add(const Type<T>& type) {
+        const qsizetype i = types.size();
+        types.append({type.name, &typeid(T), &createDefault<T>, type.tool, type.begin, &copyOf<T>});
+        byName.insert(types[i].name, i);
+        byType.emplace(typeid(T), i);
+        if (type.tool >= 0) byTool.insert(type.tool, i);
+    }
+};
+
+const Registry& registry() {
+    static const Registry instance;
+    return instance;
+}
+
+}
+
+const QList<TypeInfo>& types() {
+    return registry().types;
+}
+
+const TypeInfo* find(const QString& name) {
+    const Registry& r = registry();
+    auto it = r.byName.constFind(name);
+    return it == r.byName.constEnd() ? nullptr : &r.types[*it];
+}
+
+const TypeInfo* find(const Shape& shape) {
+    const Registry& r = registry();
+    auto it = r.byType.find(typeid(shape));
+    return it == r.byType.end() ? nullptr : &r.types[it->second];
+}
+
+const TypeInfo* findTool(int32_t tool) {
+    const Registry& r = registry();
+    auto it = r.byTool.constFind(tool);
+    return it == r.byTool.constEnd() ? nullptr : &r.types[*it];
+}
+
+std::shared_ptr<Shape> create(const QString& type) {
+    const TypeInfo* info = find(type);
+    return info ? info->create() : nullptr;
+}
+
+std::shared_ptr<Shape> begin(int32_t tool, const QPoint& start) {
+    const TypeInfo* info = findTool(tool);
+    return info ? info->begin(start) : nullptr;
+}
+
+QJsonObject toJson(const Shape& shape) {
+    QJsonObject obj = shape.toJson();
+    // The registered tag is shared, unlike a fresh name() per shape.
+    const TypeInfo* info = find(shape);
+    obj["type"] = info ? info->name : shape.name();
+    return obj;
+}
+
+std::shared_ptr<Shape> fromJson(const QJsonObject& obj) {
+    std::shared_ptr<Shape> shape = create(obj["type"].toString());
+    if (shape) {
+        shape->fromJson(obj);
+    }
+    return shape;
+}
+
+std::shared_ptr<Shape> clone(const Shape& shape) {
+    const TypeInfo* info = find(shape);
+    return info ? info->copy(shape) : nullptr;
+}
+
+namespace {
+
+std::mutex resourceMutex;
+
+std::shared_ptr<std::pmr::memory_resource>& currentResource() {
+    static std::shared_ptr<std::pmr::memory_resource> resource =
+        std::make_shared<std::pmr::synchronized_pool_resource>();
+    return resource;
+}
+
+}
+
+std::shared_ptr<std::pmr::memory_resource> shapeResource() {
+    std::lock_guard<std::mutex> lock(resourceMutex);
+    return currentResource();
+}
+
+void resetShapeResource() {
+    std::lock_guard<std::mutex> lock(resourceMutex);
+    currentResource() = std::make_shared<std::pmr::synchronized_pool_resource>();
+}
+
+}
@@ -0,0 +1,327 @@
+#include "../../include/Shapes/ShapeStyle.h"
+#include <QtMath>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct StyleHash {
+    size_t operator()(const ShapeStyle& style) const {
+        size_t seed = std::hash<quint64>()(style.stroke.rgba64());
+        seed ^= std::hash<quint64>()(style.fill.rgba64()) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= std::hash<int32_t>()(style.width * 2 + (style.filled ? 1 : 0)) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        if (style.gradient != ShapeStyle::NoGradient) {
+            seed ^= std::hash<quint64>()(style.fillEnd.rgba64() + style.gradient) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        if (style.hasEffects()) {
+            seed ^= std::hash<quint64>()(style.shadow.rgba64()) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<qreal>()(style.blur + style.shadowBlur) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
+
+thread_local StylePalette* currentPalette = nullptr;
+
+// The entry table: chunks of slots that never move, so a lookup needs no
+// lock. Id 0 is the default style and is never freed.
+constexpr quint32 ChunkBits = 10;
+constexpr quint32 ChunkSize = 1u << ChunkBits;
+constexpr quint32 MaxChunks = 4096;
+
+struct Slot {
+    ShapeStyle style;
+    int32_t refs = 0;
+};
+
+std::atomic<Slot*> chunks[MaxChunks];
+
+Slot& slot(quint32 id) {
+    return chunks[id >> ChunkBits].load(std::memory_order_acquire)[id & (ChunkSize - 1)];
+}
+
+// Invalid colors would otherwise compare equal to opaque black.
+ShapeStyle normalized(const ShapeStyle& style) {
+    ShapeStyle entry = style;
+    if (!entry.stroke.isValid()) entry.stroke = Qt::black;
+    if (!entry.fill.isValid()) entry.fill = Qt::transparent;
+    if (!entry.shadow.isValid()) entry.shadow = Qt::transparent;
+    if (!entry.fillEnd.isValid()) entry.fillEnd = Qt::transparent;
+    if (entry.gradient == ShapeStyle::NoGradient) {
+        entry.fillEnd = Qt::transparent;
+        entry.gradientAngle = 0.0;
+    } else if (entry.gradient == ShapeStyle::RadialGradient) {
+        entry.gradientAngle = 0.0;
+    }
+    entry.blur = qMax(0.0, entry.blur);
+    entry.shadowBlur = qMax(0.0, entry.shadowBlur);
+    // An invisible shadow is no shadow, whatever its offset.
+    if (entry.shadow.alpha() == 0) {
+        entry.shadow = Qt::transparent;
+        entry.shadowOffset = QPointF();
+        entry.shadowBlur = 0.0;
+    }
+    return entry;
+}
+
+}
+
+bool ShapeStyle::operator==(const ShapeStyle& other) const
+{
+    return stroke.rgba64() == other.stroke.rgba64() && width == other.width &&
+           fill.rgba64() == other.fill.rgba64() && filled == other.filled &&
+           gradient == other.gradient && fillEnd.rgba64() == other.fillEnd.rgba64() &&
+           gradientAngle == other.gradientAngle &&
+           blur == other.blur && shadow.rgba64() == other.shadow.rgba64() &&
+           shadowOffset == other.shadowOffset && shadowBlur == other.shadowBlur;
+}
+
+int32_t ShapeStyle::effectMargin() const
+{
+    // A triple box blur reaches about three deviations out.
+    qreal margin = 3.0 * blur;
+    if (shadow.alpha() > 0) {
+        margin = qMax(margin, qMax(qAbs(shadowOffset.x()), qAbs(shadowOffset.y())) + 3.0 * shadowBlur);
+    }
+    return qCeil(margin);
+}
+
+struct ShapeStyle::Table {
+    std::mutex mutex;
+    std::unordered_map<ShapeStyle, quint32, StyleHash> ids;
+    std::vector<quint32> freeIds;
+    quint32 nextId = 0;
+};
+
+ShapeStyle::Table& ShapeStyle::table()
+{
+    static Table* table = [] {
+        // Never destroyed, so shapes still held by static caches at exit
+        // can release their styles.
+        auto* created = new Table;
+        ShapeStyle entry = normalized(ShapeStyle());
+        entry.build();
+        chunks[0].store(new Slot[ChunkSize], std::memory_order_release);
+        slot(0).style = entry;
+        slot(0).refs = 1;
+        created->ids.emplace(entry, 0);
+        created->nextId = 1;
+        return created;
+    }();
+    return *table;
+}
+
+ShapeStyle::Handle ShapeStyle::intern(const ShapeStyle& style)
+{
+    ShapeStyle entry = normalized(style);
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    auto it = t.ids.find(entry);
+    if (it != t.ids.end()) {
+        if (it->second != 0) ++slot(it->second).refs;
+        return Handle(it->second);
+    }
+
+    quint32 id;
+    if (!t.freeIds.empty()) {
+        id = t.freeIds.back();
+        t.freeIds.pop_back();
+    } else {
+        if (t.nextId == MaxChunks * ChunkSize) {
+            qWarning("ShapeStyle: style table full, using the default style");
+            return Handle();
+        }
+        id = t.nextId++;
+        if ((id & (ChunkSize - 1)) == 0) {
+            chunks[id >> ChunkBits].store(new Slot[ChunkSize], std::memory_order_release);
+        }
+    }
+
+    entry.build();
+    Slot& entrySlot = slot(id);
+    entrySlot.style = entry;
+    entrySlot.refs = 1;
+    t.ids.emplace(entry, id);
+    return Handle(id);
+}
+
+const ShapeStyle& ShapeStyle::at(quint32 id)
+{
+    // The default style's chunk appears with the table.
+    if (id == 0) table();
+    return slot(id).style;
+}
+
+void ShapeStyle::retain(quint32 id)
+{
+    if (id == 0) return;
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    ++slot(id).refs;
+}
+
+void ShapeStyle::release(quint32 id)
+{
+    if (id == 0) return;
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    Slot& entrySlot = slot(id);
+    if (--entrySlot.refs > 0) return;
+
+    // No shape can reach the slot any more, so it can be reused at once.
+    t.ids.erase(entrySlot.style);
+    entrySlot.style = ShapeStyle();
+    t.freeIds.push_back(id);
+}
+
+void ShapeStyle::build()
+{
+    m_pen = QPen(stroke, width);
+    m_roundPen = QPen(stroke, width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+    m_brush = filled ? makeBrush() : QBrush(Qt::NoBrush);
+}
+
+QBrush ShapeStyle::makeBrush() const
+{
+    const QGradientStops stops = {{0.0, fill}, {1.0, fillEnd}};
+    switch (gradient) {
+    case LinearGradient: {
+        // Corner to corner of the unit square at 45 degrees, edge to edge
+        // at right angles.
+        const qreal radians = qDegreesToRadians(gradientAngle);
+        const QPointF direction(std::cos(radians), std::sin(radians));
+        const qreal reach = (qAbs(direction.x()) + qAbs(direction.y())) / 2;
+        const QPointF center(0.5, 0.5);
+        QLinearGradient linear(center - direction * reach, center + direction * reach);
+        linear.setCoordinateMode(QGradient::ObjectMode);
+        linear.setStops(stops);
+        return QBrush(linear);
+    }
+    case RadialGradient: {
+        QRadialGradient radial(0.5, 0.5, 0.5);
+        radial.setCoordinateMode(QGradient::ObjectMode);
+        radial.setStops(stops);
+        return QBrush(radial);
+    }
+    case NoGradient:
+        break;
+    }
+    return QBrush(fill);
+}
+
+void ShapeStyle::writeFields(QJsonObject& obj) const
+{
+    obj["color"] = stroke.name(QColor::HexArgb);
+    obj["penWidth"] = width;
+    obj["fillColor"] = fill.name(QColor::HexArgb);
+    obj["isFilled"] = filled;
+    if (gradient != NoGradient) {
+        obj["fillGradient"] = gradient == LinearGradient ? "linear" : "radial";
+        obj["fillEndColor"] = fillEnd.name(QColor::HexArgb);
+        if (gradient == LinearGradient) obj["gradientAngle"] = gradientAngle;
+    }
+    if (blur > 0.0) obj["blur"] = blur;
+    if (shadow.alpha() > 0) {
+        obj["shadowColor"] = shadow.name(QColor::HexArgb);
+        obj["shadowX"] = shadowOffset.x();
+        obj["shadowY"] = shadowOffset.y();
+        obj["shadowBlur"] = shadowBlur;
+    }
+}
+
+ShapeStyle ShapeStyle::readFields(const QJsonObject& obj)
+{
+    ShapeStyle style;
+    style.stroke = QColor(obj["color"].toString());
+    // Older files call the pen width "width" for some shapes; circles use
+    // that key for their geometry but always wrote "penWidth" as well.
+    style.width = obj.contains("penWidth") ? obj["penWidth"].toInt() : obj["width"].toInt();
+    if (obj.contains("fillColor")) style.fill = QColor(obj["fillColor"].toString());
+    style.filled = obj["isFilled"].toBool();
+    const QString gradient = obj["fillGradient"].toString();
+    if (gradient == "linear" || gradient == "radial") {
+        style.gradient = gradient == "linear" ? LinearGradient : RadialGradient;
+        style.fillEnd = QColor(obj["fillEndColor"].toString());
+        style.gradientAngle = obj["gradientAngle"].toDouble();
+    }
+    style.blur = obj["blur"].toDouble();
+    if (obj.contains("shadowColor")) {
+        style.shadow = QColor(obj["shadowColor"].toString());
+        style.shadowOffset = QPointF(obj["shadowX"].toDouble(), obj["shadowY"].toDouble());
+        style.shadowBlur = obj["shadowBlur"].toDouble();
+    }
+    return style;
+}
+
+void ShapeStyle::write(const Handle& style, QJsonObject& obj)
+{
+    if (StylePalette* palette = StylePalette::current()) {
+        obj["style"] = palette->indexOf(style);
+    } else {
+        style->writeFields(obj);
+    }
+}
+
+ShapeStyle::Handle ShapeStyle::read(const QJsonObject& obj)
+{
+    StylePalette* palette = StylePalette::current();
+    if (palette && obj.contains("style")) {
+        return palette->at(obj["style"].toInt());
+    }
+    return intern(readFields(obj));
+}
+
+int32_t StylePalette::indexOf(const ShapeStyle::Handle& style)
+{
+    auto it = m_indices.constFind(style.id());
+    if (it != m_indices.constEnd()) return *it;
+
+    const int32_t index = m_styles.size();
+    m_styles.append(style);
+    m_indices.insert(style.id(), index);
+    return index;
+}
+
+ShapeStyle::Handle StylePalette::at(int32_t index) const
+{
+    return index >= 0 && index < m_styles.size() ? m_styles[index] : ShapeStyle::defaultStyle();
+}
+
+QJsonArray StylePalette::toJson() const
+{
+    QJsonArray array;
+    for (const ShapeStyle::Handle& style : m_styles) {
+        QJsonObject obj;
+        style->writeFields(obj);
+        array.append(obj);
+    }
+    return array;
+}
+
+void StylePalette::fromJson(const QJsonArray& array)
+{
+    m_styles.clear();
+    m_indices.clear();
+    for (const QJsonValue& value : array) {
+        indexOf(ShapeStyle::intern(ShapeStyle::readFields(value.toObject())));
+    }
+}
+
+StylePalette* StylePalette::current()
+{
+    return currentPalette;
+}
+
+StylePalette::Scope::Scope(StylePalette& palette)
+    : m_previous(currentPalette)
+{
+    currentPalette = &palette;
+}
+
+StylePalette::Scope::~Scope()
+{
+    currentPalette = m_previous;
+}
@@ -0,0 +1,115 @@
+#include "../../include/Shapes/SymbolDefinition.h"
+#include "../../include/Shapes/ShapeFactory.h"
+#include "../../include/Shapes/GroupShape.h"
+#include "../../include/Shapes/InstanceShape.h"
+#include "../../include/Rendering/LodPolicy.h"
+#include <QPainter>
+#include <QSet>
+#include <QUuid>
+#include <QtMath>
+#include <cmath>
+#include <functional>
+
+namespace {
+    std::mutex registryMutex;
+    QHash<QString, std::weak_ptr<SymbolDefinition>>& registry() {
+        static QHash<QString, std::weak_ptr<SymbolDefinition>> symbols;
+        return symbols;
+    }
+}
+
+SymbolDefinition::SymbolDefinition(std::shared_ptr<Shape> geometry, const QString& id)
+    : m_id(id), m_geometry(std::move(geometry)), m_bounds(m_geometry->boundingRect())
+{
+}
+
+std::shared_ptr<SymbolDefinition> SymbolDefinition::create(std::shared_ptr<Shape> geometry, const QString& id) {
+    if (!geometry) return nullptr;
+
+    QString symbolId = id.isEmpty() ? QUuid::createUuid().toString(QUuid::WithoutBraces) : id;
+    std::shared_ptr<SymbolDefinition> symbol(new SymbolDefinition(std::move(geometry), symbolId));
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry().insert(symbolId, symbol);
+    return symbol;
+}
+
+std::shared_ptr<SymbolDefinition> SymbolDefinition::find(const QString& id) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = registry().find(id);
+    if (it == registry().end()) return nullptr;
+
+    std::shared_ptr<SymbolDefinition> symbol = it->lock();
+    if (!symbol) registry().erase(it);
+    return symbol;
+}
+
+QList<std::shared_ptr<SymbolDefinition>> SymbolDefinition::collect(const QList<std::shared_ptr<Shape>>& shapes) {
+    QList<std::shared_ptr<SymbolDefinition>> result;
+    QSet<const SymbolDefinition*> seen;
+
+    std::function<void(const Shape&)> visit = [&](const Shape& shape) {
+        if (auto group = dynamic_cast<const GroupShape*>(&shape)) {
+            for (const auto& child : group->children()) visit(*child);
+        } else if (auto instance = dynamic_cast<const InstanceShape*>(&shape)) {
+            const auto& symbol = instance->symbol();
+            if (!symbol || seen.contains(symbol.get())) return;
+            seen.insert(symbol.get());
+            visit(symbol->geometry());
+            result.append(symbol);
+        }
+    };
+    for (const auto& shape : shapes) {
+        visit(*shape);
+    }
+    return result;
+}
+
+QPainterPath SymbolDefinition::path(qreal scale) const {
+    const int32_t level = Lod::levelForScale(scale);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_paths.constFind(level);
+    if (it == m_paths.constEnd()) {
+        it = m_paths.insert(level, m_geometry->renderPath(std::ldexp(1.0, level)));
+    }
+    return *it;
+}
+
+QImage SymbolDefinition::raster(qreal scale) const {
+    const int32_t level = Lod::levelForScale(scale);
+    const qreal levelScale = std::ldexp(1.0, level);
+    const QRect rect = rasterRect();
+    if (qMax(rect.width(), rect.height()) * levelScale > MaxRasterSize) return QImage();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_rasters.constFind(level);
+    if (it != m_rasters.constEnd()) return *it;
+
+    if (m_rasters.size() >= MaxCachedRasters) {
+        m_rasters.clear();
+    }
+
+    QImage image(qMax(1, qCeil(rect.width() * levelScale)), qMax(1, qCeil(rect.height() * levelScale)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.scale(levelScale, levelScale);
+    painter.translate(-rect.topLeft());
+    m_geometry->drawLod(painter, levelScale);
+    painter.end();
+
+    m_rasters.insert(level, image);
+    return image;
+}
+
+QJsonObject SymbolDefinition::toJson() const {
+    QJsonObject obj;
+    obj["id"] = m_id;
+    obj["shape"] = ShapeFactory::toJson(*m_geometry);
+    return obj;
+}
+
+std::shared_ptr<SymbolDefinition> SymbolDefinition::fromJson(const QJsonObject& obj) {
+    return create(ShapeFactory::fromJson(obj["shape"].toObject()), obj["id"].toString());
+}
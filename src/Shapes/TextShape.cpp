@@ -0,0 +1,187 @@
+#include "../../include/Shapes/TextShape.h"
+#include <QPainter>
+#include <QTextLayout>
+#include <QtMath>
+
+TextShape::TextShape()
+{
+    m_font.setPixelSize(DefaultPixelSize);
+    relayout();
+}
+
+TextShape::TextShape(const QPoint& position, const QString& text)
+    : m_text(text), m_position(position)
+{
+    m_font.setPixelSize(DefaultPixelSize);
+    relayout();
+}
+
+void TextShape::relayout()
+{
+    m_lines.clear();
+    m_extent = QRectF();
+
+    QTextOption option;
+    option.setWrapMode(QTextOption::NoWrap);
+
+    qreal top = 0.0;
+    const QStringList paragraphs = m_text.split('\n');
+    m_lines.reserve(paragraphs.size());
+    for (const QString& paragraph : paragraphs) {
+        QTextLayout layout(paragraph, m_font);
+        layout.setTextOption(option);
+        layout.beginLayout();
+        QTextLine line = layout.createLine();
+        if (line.isValid()) {
+            line.setNumColumns(qMax(1, paragraph.size()));
+            line.setPosition(QPointF(0, 0));
+        }
+        layout.endLayout();
+        if (!line.isValid()) continue;
+
+        Line entry;
+        entry.runs = line.glyphRuns();
+        entry.box = QRectF(0, top, line.naturalTextWidth(), line.height());
+        m_extent |= entry.box;
+        m_lines.append(entry);
+        top += line.height();
+    }
+}
+
+QTransform TextShape::rotationTransform() const
+{
+    const QPointF center = m_extent.translated(m_position).center();
+    QTransform transform;
+    transform.translate(center.x(), center.y());
+    transform.rotate(rotation_);
+    transform.translate(-center.x(), -center.y());
+    return transform;
+}
+
+void TextShape::draw(QPainter& painter) const
+{
+    drawLines(painter, false);
+}
+
+void TextShape::drawLod(QPainter& painter, qreal scale) const
+{
+    drawLines(painter, m_font.pixelSize() * scale < MinReadableSize);
+}
+
+void TextShape::drawLines(QPainter& painter, bool bars) const
+{
+    painter.save();
+    if (rotation_ != 0.0) {
+        painter.setTransform(rotationTransform(), true);
+    }
+
+    if (bars) {
+        // Unreadable anyway; a bar per line keeps the block's shape.
+        QColor color = style().stroke;
+        color.setAlphaF(color.alphaF() * 0.5);
+        for (const Line& line : m_lines) {
+            QRectF box = line.box.translated(m_position);
+            painter.fillRect(box.adjusted(0, box.height() / 4, 0, -box.height() / 4), color);
+        }
+    } else {
+        painter.setPen(style().stroke);
+        for (const Line& line : m_lines) {
+            const QPointF origin = m_position + line.box.topLeft();
+            for (const QGlyphRun& run : line.runs) {
+                painter.drawGlyphRun(origin, run);
+            }
+        }
+    }
+    painter.restore();
+}
+
+bool TextShape::contains(const QPoint& pos) const
+{
+    QPointF local = pos;
+    if (rotation_ != 0.0) {
+        local = rotationTransform().inverted().map(local);
+    }
+    local -= m_position;
+
+    for (const Line& line : m_lines) {
+        if (line.box.contains(local)) return true;
+    }
+    return false;
+}
+
+void TextShape::moveBy(int32_t dx, int32_t dy)
+{
+    m_position += QPoint(dx, dy);
+}
+
+void TextShape::resize(const QSize& size)
+{
+    if (m_extent.height() <= 0 || size.height() <= 0) return;
+
+    // Text keeps its proportions; the height picks the font size.
+    const qreal factor = size.height() / m_extent.height();
+    const int32_t pixelSize = qMax(1, qRound(m_font.pixelSize() * factor));
+    if (pixelSize == m_font.pixelSize()) return;
+
+    m_font.setPixelSize(pixelSize);
+    relayout();
+}
+
+void TextShape::rotate(double angle)
+{
+    rotation_ = angle;
+}
+
+void TextShape::update(const QPoint& toPoint)
+{
+    m_position = toPoint;
+}
+
+void TextShape::setText(const QString& text)
+{
+    if (text == m_text) return;
+    m_text = text;
+    relayout();
+}
+
+void TextShape::setFont(const QFont& font)
+{
+    if (font == m_font) return;
+    m_font = font;
+    relayout();
+}
+
+QRect TextShape::boundingRect() const
+{
+    if (m_lines.isEmpty()) return QRect();
+
+    QRectF extent = m_extent.translated(m_position);
+    if (rotation_ != 0.0) {
+        extent = rotationTransform().mapRect(extent);
+    }
+    return extent.toAlignedRect();
+}
+
+QJsonObject TextShape::toJson() const
+{
+    QJsonObject obj;
+    obj["text"] = m_text;
+    obj["x"] = m_position.x();
+    obj["y"] = m_position.y();
+    obj["fontFamily"] = m_font.family();
+    obj["fontSize"] = m_font.pixelSize();
+    writeCommon(obj);
+    return obj;
+}
+
+void TextShape::fromJson(const QJsonObject& obj)
+{
+    m_text = obj["text"].toString();
+    m_position = QPoint(obj["x"].toInt(), obj["y"].toInt());
+    if (obj.contains("fontFamily")) {
+        m_font.setFamily(obj["fontFamily"].toString());
+    }
+    m_font.setPixelSize(qMax(1, obj["fontSize"].toInt(DefaultPixelSize)));
+    readCommon(obj);
+    relayout();
+}
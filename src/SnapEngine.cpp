@@ -0,0 +1,122 @@
+#include "../include/SnapEngine.h"
+#include <QtMath>
+#include <algorithm>
+
+bool SnapEngine::snap(const QPointF& pos, qreal radius, const QList<const SpatialIndex*>& indexes,
+                      const QSet<const Shape*>& exclude, Hit& hit)
+{
+    qreal best = radius * radius;
+    bool found = false;
+
+    if (m_targets & Objects) {
+        const int32_t reach = qCeil(radius);
+        const QRect area = QRect(pos.toPoint(), QSize(1, 1)).adjusted(-reach, -reach, reach, reach);
+        for (const SpatialIndex* index : indexes) {
+            for (const auto& shape : index->query(area)) {
+                if (exclude.contains(shape.get())) continue;
+
+                const QVector<Candidate>& candidates = candidatesOf(*shape);
+                auto it = std::lower_bound(candidates.cbegin(), candidates.cend(), pos.x() - radius,
+                                           [](const Candidate& c, qreal x) { return c.pos.x() < x; });
+                for (; it != candidates.cend() && it->pos.x() <= pos.x() + radius; ++it) {
+                    if (!(m_targets & it->kind)) continue;
+                    const QPointF d = it->pos - pos;
+                    const qreal distance = QPointF::dotProduct(d, d);
+                    if (distance <= best) {
+                        best = distance;
+                        hit = {it->pos, it->kind};
+                        found = true;
+                    }
+                }
+            }
+        }
+        prune(indexes);
+    }
+
+    if (!found && (m_targets & Grid)) {
+        const QPointF grid(qRound(pos.x() / GridSize) * qreal(GridSize), qRound(pos.y() / GridSize) * qreal(GridSize));
+        const QPointF d = grid - pos;
+        if (QPointF::dotProduct(d, d) <= best) {
+            hit = {grid, Grid};
+            found = true;
+        }
+    }
+    return found;
+}
+
+QVector<SnapEngine::Candidate> SnapEngine::collect(const Shape& shape)
+{
+    QVector<Candidate> candidates;
+
+    const QRectF bounds = shape.boundingRect();
+    if (!bounds.isEmpty()) {
+        const QPointF center = bounds.center();
+        candidates = {
+            {bounds.topLeft(), Bounds}, {bounds.topRight(), Bounds},
+            {bounds.bottomLeft(), Bounds}, {bounds.bottomRight(), Bounds},
+            {QPointF(center.x(), bounds.top()), Bounds}, {QPointF(center.x(), bounds.bottom()), Bounds},
+            {QPointF(bounds.left(), center.y()), Bounds}, {QPointF(bounds.right(), center.y()), Bounds},
+            {center, Centers},
+        };
+    }
+
+    const QPainterPath path = shape.snapPath();
+    if (path.elementCount() <= MaxPathElements) {
+        QPointF previous;
+        for (int32_t i = 0; i < path.elementCount(); ++i) {
+            const QPainterPath::Element element = path.elementAt(i);
+            switch (element.type) {
+            case QPainterPath::MoveToElement:
+                previous = element;
+                candidates.append({previous, Vertices});
+                break;
+            case QPainterPath::LineToElement:
+                if (QPointF(element) != previous) {
+                    candidates.append({(previous + QPointF(element)) / 2, Midpoints});
+                }
+                previous = element;
+                candidates.append({previous, Vertices});
+                break;
+            case QPainterPath::CurveToElement:
+                // Two control points, then the end point.
+                i += 2;
+                previous = path.elementAt(i);
+                candidates.append({previous, Vertices});
+                break;
+            case QPainterPath::CurveToDataElement:
+                break;
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.pos.x() < b.pos.x();
+    });
+    return candidates;
+}
+
+const QVector<SnapEngine::Candidate>& SnapEngine::candidatesOf(const Shape& shape)
+{
+    Entry& entry = m_entries[&shape];
+    if (entry.version != shape.version()) {
+        entry.version = shape.version();
+        entry.candidates = collect(shape);
+    }
+    return entry.candidates;
+}
+
+void SnapEngine::prune(const QList<const SpatialIndex*>& indexes)
+{
+    qsizetype indexed = 0;
+    for (const SpatialIndex* index : indexes) {
+        indexed += index->size();
+    }
+    if (m_entries.size() <= indexed * 2 + 64) return;
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const bool live = std::any_of(indexes.cbegin(), indexes.cend(), [&it](const SpatialIndex* index) {
+            return index->contains(it.key());
+        });
+        it = live ? std::next(it) : m_entries.erase(it);
+    }
+}
@@ -0,0 +1,190 @@
+#include "../include/SpatialIndex.h"
+#include <QSet>
+#include <algorithm>
+#include <limits>
+
+namespace {
+    int32_t floorDiv(int32_t value, int32_t divisor) {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+}
+
+void SpatialIndex::clear() {
+    m_entries.clear();
+    m_cells.clear();
+    m_oversized.clear();
+    m_nextOrder = 0;
+}
+
+void SpatialIndex::rebuild(const QList<std::shared_ptr<Shape>>& shapes) {
+    clear();
+    m_entries.reserve(shapes.size());
+    for (const auto& shape : shapes) {
+        insert(shape);
+    }
+}
+
+void SpatialIndex::insert(const std::shared_ptr<Shape>& shape) {
+    remove(shape.get());
+    add(shape, m_nextOrder++);
+}
+
+void SpatialIndex::add(const std::shared_ptr<Shape>& shape, int32_t order) {
+    Entry entry;
+    entry.shape = shape;
+    entry.order = order;
+    entry.bounds = shape->renderBounds().adjusted(-BoundsMargin, -BoundsMargin, BoundsMargin, BoundsMargin);
+    link(shape.get(), entry);
+    m_entries.insert(shape.get(), entry);
+}
+
+void SpatialIndex::update(const Shape* shape) {
+    auto it = m_entries.find(shape);
+    if (it == m_entries.end()) return;
+
+    QRect bounds = shape->renderBounds().adjusted(-BoundsMargin, -BoundsMargin, BoundsMargin, BoundsMargin);
+    if (bounds == it->bounds) return;
+
+    unlink(shape, *it);
+    it->bounds = bounds;
+    link(shape, *it);
+}
+
+void SpatialIndex::remove(const Shape* shape) {
+    auto it = m_entries.find(shape);
+    if (it == m_entries.end()) return;
+
+    unlink(shape, *it);
+    m_entries.erase(it);
+}
+
+void SpatialIndex::replace(const Shape* shape, const QList<std::shared_ptr<Shape>>& pieces) {
+    auto it = m_entries.find(shape);
+    if (it == m_entries.end()) return;
+
+    const int32_t order = it->order;
+    remove(shape);
+    for (const auto& piece : pieces) {
+        remove(piece.get());
+        add(piece, order);
+    }
+}
+
+void SpatialIndex::setHidden(const Shape* shape, bool hidden) {
+    auto it = m_entries.find(shape);
+    if (it != m_entries.end()) it->hidden = hidden;
+}
+
+QRect SpatialIndex::bounds(const Shape* shape) const {
+    auto it = m_entries.constFind(shape);
+    return it == m_entries.constEnd() ? QRect() : it->bounds;
+}
+
+QRect SpatialIndex::boundingRect() const {
+    QRect result;
+    for (const Entry& entry : m_entries) {
+        result |= entry.bounds;
+    }
+    return result;
+}
+
+void SpatialIndex::sortByOrder(QList<std::shared_ptr<Shape>>& shapes) const {
+    auto orderOf = [this](const std::shared_ptr<Shape>& shape) {
+        auto it = m_entries.constFind(shape.get());
+        return it == m_entries.constEnd() ? std::numeric_limits<int32_t>::max() : it->order;
+    };
+    std::stable_sort(shapes.begin(), shapes.end(), [&orderOf](const auto& a, const auto& b) {
+        return orderOf(a) < orderOf(b);
+    });
+}
+
+QList<std::shared_ptr<Shape>> SpatialIndex::query(const QRect& area, QVector<QRect>* bounds) const {
+    QVector<const Entry*> hits;
+    QRect range = cellRange(area);
+    qint64 cellCount = qint64(range.width()) * range.height();
+
+    if (cellCount > m_cells.size()) {
+        // Area is larger than the populated grid; a flat scan is cheaper.
+        for (const Entry& entry : m_entries) {
+            if (!entry.hidden && entry.bounds.intersects(area)) hits.append(&entry);
+        }
+    } else {
+        QSet<const Shape*> seen;
+        auto collect = [&](const Shape* shape) {
+            if (seen.contains(shape)) return;
+            seen.insert(shape);
+            const Entry& entry = *m_entries.constFind(shape);
+            if (!entry.hidden && entry.bounds.intersects(area)) hits.append(&entry);
+        };
+
+        for (int32_t cy = range.top(); cy <= range.bottom(); ++cy) {
+            for (int32_t cx = range.left(); cx <= range.right(); ++cx) {
+                auto cell = m_cells.constFind(cellKey(cx, cy));
+                if (cell == m_cells.constEnd()) continue;
+                for (const Shape* shape : *cell) collect(shape);
+            }
+        }
+        for (const Shape* shape : m_oversized) collect(shape);
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const Entry* a, const Entry* b) {
+        return a->order < b->order;
+    });
+
+    QList<std::shared_ptr<Shape>> result;
+    result.reserve(hits.size());
+    if (bounds) {
+        bounds->clear();
+        bounds->reserve(hits.size());
+    }
+    for (const Entry* entry : hits) {
+        result.append(entry->shape);
+        if (bounds) bounds->append(entry->bounds);
+    }
+    return result;
+}
+
+QList<std::shared_ptr<Shape>> SpatialIndex::query(const QPoint& pos) const {
+    return query(QRect(pos, QSize(1, 1)));
+}
+
+quint64 SpatialIndex::cellKey(int32_t cx, int32_t cy) {
+    return (quint64(quint32(cx)) << 32) | quint32(cy);
+}
+
+QRect SpatialIndex::cellRange(const QRect& bounds) {
+    return QRect(QPoint(floorDiv(bounds.left(), CellSize), floorDiv(bounds.top(), CellSize)),
+                 QPoint(floorDiv(bounds.right(), CellSize), floorDiv(bounds.bottom(), CellSize)));
+}
+
+void SpatialIndex::link(const Shape* shape, Entry& entry) {
+    QRect range = cellRange(entry.bounds);
+    entry.oversized = qint64(range.width()) * range.height() > MaxCellsPerShape;
+
+    if (entry.oversized) {
+        m_oversized.append(shape);
+        return;
+    }
+    for (int32_t cy = range.top(); cy <= range.bottom(); ++cy) {
+        for (int32_t cx = range.left(); cx <= range.right(); ++cx) {
+            m_cells[cellKey(cx, cy)].append(shape);
+        }
+    }
+}
+
+void SpatialIndex::unlink(const Shape* shape, const Entry& entry) {
+    if (entry.oversized) {
+        m_oversized.removeOne(shape);
+        return;
+    }
+
+    QRect range = cellRange(entry.bounds);
+    for (int32_t cy = range.top(); cy <= range.bottom(); ++cy) {
+        for (int32_t cx = range.left(); cx <= range.right(); ++cx) {
+            auto cell = m_cells.find(cellKey(cx, cy));
+            if (cell == m_cells.end()) continue;
+            cell->removeOne(shape);
+            if (cell->isEmpty()) m_cells.erase(cell);
+        }
+    }
+}
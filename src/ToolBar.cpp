@@ -98,6 +98,27 @@ void ToolBar::createActions() {
     m_regularPolygonAction->setData(RegularPolygonTool);
     m_toolActionGroup->addAction(m_regularPolygonAction);
     m_regularPolygonAction->setToolTip("Create regular polygon");
+
+    // Eraser tool
+    m_eraserAction = new QAction(QIcon("../resources/icons/eraser.svg"), tr("Eraser"), this);
+    m_eraserAction->setCheckable(true);
+    m_eraserAction->setData(EraserTool);
+    m_toolActionGroup->addAction(m_eraserAction);
+    m_eraserAction->setToolTip("Erase parts of free hand lines (drag over them)");
+
+    // Fill tool
+    m_fillAction = new QAction(QIcon("../resources/icons/fill.svg"), tr("Fill"), this);
+    m_fillAction->setCheckable(true);
+    m_fillAction->setData(FillTool);
+    m_toolActionGroup->addAction(m_fillAction);
+    m_fillAction->setToolTip("Fill the area enclosed by lines");
+
+    // Text tool
+    m_textAction = new QAction(QIcon("../resources/icons/text.svg"), tr("Text"), this);
+    m_textAction->setCheckable(true);
+    m_textAction->setData(TextTool);
+    m_toolActionGroup->addAction(m_textAction);
+    m_textAction->setToolTip("Add text (click on text to edit it)");
     
     // Other actions
     m_undoAction = new QAction(QIcon("../resources/icons/undo.svg"), tr("Undo"), this);
@@ -120,6 +141,9 @@ void ToolBar::setupUi() {
     addAction(m_freehandAction);
     addAction(m_polygonAction);
     addAction(m_regularPolygonAction);
+    addAction(m_eraserAction);
+    addAction(m_fillAction);
+    addAction(m_textAction);
     
     addSeparator();
     
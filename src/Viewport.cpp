@@ -0,0 +1,51 @@
+#include "../include/Viewport.h"
+#include <QtMath>
+#include <cmath>
+
+QTransform Viewport::transform() const {
+    return QTransform(m_zoom, 0, 0, m_zoom, m_offset.x(), m_offset.y());
+}
+
+QPointF Viewport::mapToWorld(const QPointF& devicePos) const {
+    return (devicePos - m_offset) / m_zoom;
+}
+
+QRectF Viewport::mapToWorld(const QRectF& deviceRect) const {
+    return QRectF(mapToWorld(deviceRect.topLeft()), deviceRect.size() / m_zoom);
+}
+
+QPointF Viewport::mapFromWorld(const QPointF& worldPos) const {
+    return worldPos * m_zoom + m_offset;
+}
+
+QRectF Viewport::mapFromWorld(const QRectF& worldRect) const {
+    return QRectF(mapFromWorld(worldRect.topLeft()), worldRect.size() * m_zoom);
+}
+
+void Viewport::setZoom(qreal zoom) {
+    m_zoom = qBound(MinZoom, zoom, MaxZoom);
+}
+
+void Viewport::zoomAt(const QPointF& devicePos, qreal factor) {
+    // Keep the world point under the cursor fixed on screen.
+    QPointF anchor = mapToWorld(devicePos);
+    setZoom(m_zoom * factor);
+    m_offset = devicePos - anchor * m_zoom;
+}
+
+void Viewport::panBy(const QPointF& deviceDelta) {
+    m_offset += deviceDelta;
+}
+
+void Viewport::fit(const QRectF& worldRect, const QSize& viewportSize) {
+    if (worldRect.isEmpty() || viewportSize.isEmpty()) return;
+
+    qreal scaleX = viewportSize.width() / worldRect.width();
+    qreal scaleY = viewportSize.height() / worldRect.height();
+    setZoom(qMin(scaleX, scaleY));
+    m_offset = -worldRect.topLeft() * m_zoom;
+}
+
+int32_t Viewport::level() const {
+    return static_cast<int32_t>(std::ceil(std::log2(m_zoom) - 1e-6));
+}